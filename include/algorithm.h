@@ -8,6 +8,7 @@
 #include <cstring>
 #include <utility>
 #include <cstddef>
+#include <type_traits>
 
 #include "type_traits.h"
 #include "iterator.h"
@@ -77,12 +78,14 @@ namespace tt{
     //*********** [swap] ********************
     //********* [Algorithm Complexity: O(1)] ****************
 
+    // 通过移动交换，容器之类的对象只交换内部指针，不复制元素
     template<class T>
     void
-    swap(T &x, T &y) {
-         T tmp = x;
-         x = y;
-         y = tmp;
+    swap(T &x, T &y) noexcept(std::is_nothrow_move_constructible<T>::value &&
+                              std::is_nothrow_move_assignable<T>::value) {
+         T tmp = std::move(x);
+         x = std::move(y);
+         y = std::move(tmp);
     }
 
     //*********** [for_each] ********************
@@ -108,7 +111,9 @@ namespace tt{
 
     template<class T>
     inline T *__copy_backward_t(T *first, T *last, T *result, true_type) {
-        memmove(result - (last - first), first, sizeof(T) * (last - first));
+        if (first != last) {  // 空区间的指针可能是空指针，不能交给memmove
+            memmove(result - (last - first), first, sizeof(T) * (last - first));
+        }
         return result + (last - first);
     }
 
@@ -188,7 +193,9 @@ namespace tt{
 
     template<class T>
     inline T* __copy_t(T *first, T *last, T *result, true_type) {
-        memmove(result, first, sizeof(T) * (last - first));
+        if (first != last) {  // 空区间的指针可能是空指针，不能交给memmove
+            memmove(result, first, sizeof(T) * (last - first));
+        }
         return result + (last - first);
     }
 
@@ -230,6 +237,71 @@ namespace tt{
         return result + dist;
     }
 
+    //********** [move] / [move_backward] ******************************
+    //********* [Algorithm Complexity: O(N)] ****************
+    template<class T>
+    inline T *__move_t(T *first, T *last, T *result, true_type) {
+        if (first != last) {  // 空区间的指针可能是空指针，不能交给memmove
+            memmove(result, first, sizeof(T) * (last - first));
+        }
+        return result + (last - first);
+    }
+
+    template<class T>
+    inline T *__move_t(T *first, T *last, T *result, false_type) {
+        for (; first != last; ++first, ++result) {
+            *result = std::move(*first);
+        }
+        return result;
+    }
+
+    template<class T>
+    inline T *__move_backward_t(T *first, T *last, T *result, true_type) {
+        if (first != last) {
+            memmove(result - (last - first), first, sizeof(T) * (last - first));
+        }
+        return result - (last - first);
+    }
+
+    template<class T>
+    inline T *__move_backward_t(T *first, T *last, T *result, false_type) {
+        while (first != last) {
+            *--result = std::move(*--last);
+        }
+        return result;
+    }
+
+    // 同 copy / copy_backward，但逐个移动赋值；移动赋值平凡的类型直接 memmove
+    // (不能看拷贝赋值：拷贝赋值是默认的、移动赋值是自己写的类型，memmove会绕过它的移动赋值)
+    template<class InputIterator, class OutputIterator>
+    inline OutputIterator move(InputIterator first, InputIterator last, OutputIterator result) {
+        for (; first != last; ++first, ++result) {
+            *result = std::move(*first);
+        }
+        return result;
+    }
+
+    template<class T>
+    inline T *move(T *first, T *last, T *result) {
+        typedef typename tt::integral_constant<bool, std::is_trivially_move_assignable<T>::value>::type t;
+        return __move_t(first, last, result, t());
+    }
+
+    template<class BidirectionalIterator1, class BidirectionalIterator2>
+    inline BidirectionalIterator2 move_backward(BidirectionalIterator1 first, BidirectionalIterator1 last,
+                                                BidirectionalIterator2 result) {
+        while (first != last) {
+            *--result = std::move(*--last);
+        }
+        return result;
+    }
+
+    template<class T>
+    inline T *move_backward(T *first, T *last, T *result) {
+        typedef typename tt::integral_constant<bool, std::is_trivially_move_assignable<T>::value>::type t;
+        return __move_backward_t(first, last, result, t());
+    }
+
 
 
 
@@ -5,7 +5,39 @@
 #ifndef TINYSTL_ALLOC_H
 #define TINYSTL_ALLOC_H
 
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <condition_variable>
+#include <ostream>
+#include <fstream>
+#include <atomic>
+#include <cmath>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#endif
+#if defined(__has_include)
+#if __has_include(<execinfo.h>)
+#include <execinfo.h>
+#define TINYSTL_HAVE_BACKTRACE
+#endif
+#endif
 
+//定义TINYSTL_ALLOC_STATS后，alloc为每个free-list统计分配、回收、refill次数与占用字节数；
+//未定义时统计代码完全不参与编译，stats()返回全零的快照
+#ifdef TINYSTL_ALLOC_STATS
+#define TINYSTL_ALLOC_STAT(expr) expr
+#else
+#define TINYSTL_ALLOC_STAT(expr)
+#endif
 
 
 namespace tt {
@@ -13,13 +45,86 @@ namespace tt {
     /*
 	**空间配置器，以字节数为单位分配
 	**内部使用
+	**
+	**每个线程持有自己的free-lists(thread_cache)，分配与回收都不加锁；
+	**线程缓存过长时把一整批区块交给中央仓库(central_depot)，
+	**缺货时再从仓库整批取回，仓库也空了才去加锁的内存池里切。
+	**
+	**每个线程还有一个heap，持有自己的内存池和chunk。区块回收时按所在chunk找到所属heap：
+	**属于本线程的放回线程缓存；属于别的线程的放进那个heap的远程回收队列(无锁)，
+	**由所属线程在缺货时整条取回。这样生产者分配、消费者回收的区块会回到生产者手里。
+	**线程退出后它的heap成为孤儿，由之后新建的线程接管；回收到孤儿heap的区块直接留在本线程。
+	**
+	**区块分两档：
+	**  小型区块(<=128字节)按8字节递增，共16个free-list；
+	**  中型区块(128字节, 32KB]每翻一倍分4档(160,192,224,256,320,...,32768)，
+	**  从内存池中按页对齐切出的一段连续页(page run)里切分。
+	**超过32KB的区块由malloc分配。
+	**
+	**每个区块都按其大小的最低位对齐(最多64字节)，例如48字节的区块16字节对齐，
+	**192字节的区块64字节对齐。allocate(bytes, align)据此挑选对齐足够的free-list，
+	**超过64字节的对齐要求交给aligned_alloc。
+	**
+	**内存池由一个个chunk组成，chunk按64KB对齐、大小是64KB的整数倍，
+	**开头放一个chunk_header，并登记在chunk_map里，由区块地址可以O(1)找到所属chunk。
+	**trim()找出所有区块都已空闲的chunk还给操作系统。
+	**chunk从可替换的chunk_source申请：默认是aligned_alloc，
+	**也可以用set_chunk_source(huge_page_source)改为mmap出来的大页，减少遍历大容器时的TLB miss。
+	**
+	**线程缓存缺货、只能从内存池切分时，一次切多少个区块由refill_policy决定：
+	**默认的adaptive_refill按每个线程各free-list的缺货频率调整，频繁缺货的free-list每次翻倍，
+	**很久才缺货一次的减半；fixed_refill是原来的固定批量。可以用set_refill_policy()替换。
+	**
+	**set_memory_budget()限制内存池chunk与大区块的总占用(footprint)：越过软上限时调用注册的pressure handler
+	**并trim()；超过硬上限或者操作系统拿不出内存时，先同样处理一遍，仍然不够再反复调用oom handler(同SGI的
+	**set_malloc_handler)，没有oom handler时抛出std::bad_alloc。
+	**
+	**定义TINYSTL_ALLOC_STATS时可以通过stats()/dump_stats()查看统计信息。
+	**set_profile_sample_rate()打开采样式堆剖析，dump_heap_profile()输出pprof可读的堆剖析。
 	*/
     class alloc{
     private:
         enum EAlign{ ALIGN = 8}; //小型区块的上调边界
-        enum EMaxBytes{ MAXBYTES = 128};//小型区块的上限，超过的区块由malloc分配
-        enum ENFreeLists{ NFREELISTS = (EMaxBytes::MAXBYTES / EAlign::ALIGN)};//free-lists的个数
+        enum EMaxAlign{ MAX_ALIGN = 64};//free-list能保证的最大对齐，超过的对齐要求交给aligned_alloc
+        enum ESmallShift{ SMALL_SHIFT = 7};//小型区块上限为2^7
+        enum EMaxShift{ MAX_SHIFT = 15};//中型区块上限为2^15
+        enum EClassesPerDoubling{ CLASSES_PER_DOUBLING = 4};//中型区块每翻一倍分几档
+        enum EMaxSmallBytes{ MAXSMALLBYTES = 1 << ESmallShift::SMALL_SHIFT};//小型区块的上限
+        enum EMaxBytes{ MAXBYTES = 1 << EMaxShift::MAX_SHIFT};//free-list管理的区块上限，超过的区块由malloc分配
+        enum ENSmallLists{ NSMALLLISTS = (EMaxSmallBytes::MAXSMALLBYTES / EAlign::ALIGN)};//小型free-lists的个数
+        enum ENFreeLists{ NFREELISTS = ENSmallLists::NSMALLLISTS +
+                (EMaxShift::MAX_SHIFT - ESmallShift::SMALL_SHIFT) * EClassesPerDoubling::CLASSES_PER_DOUBLING};//free-lists的个数
         enum ENObjs{ NOBJS = 20};//每次增加的节点数
+        enum EMinRefillObjs{ MIN_REFILL_OBJS = 4};//adaptive_refill每次至少切出的区块数，也是第一次切出的区块数
+        enum EMaxRefillObjs{ MAX_REFILL_OBJS = 1024};//adaptive_refill每次最多切出的区块数
+        enum EMaxRefillBytes{ MAX_REFILL_BYTES = 256 * 1024};//adaptive_refill每次最多切出的字节数
+        enum EHotGap{ HOT_GAP = 16};//两次切分之间本线程其他free-list切分不到这么多次，视为热点，批量翻倍
+        enum EColdGap{ COLD_GAP = 256};//超过这么多次，视为冷门，批量减半
+        enum EPageSize{ PAGE_SIZE = 4096};//page run的对齐边界
+        enum ERunBytes{ RUN_BYTES = 64 * 1024};//中型区块每次refill期望切出的字节数
+        enum EDepotSlots{ DEPOT_SLOTS = 64};//中央仓库每个free-list最多缓存的整批数
+        enum EChunkShift{ CHUNK_SHIFT = 16};//chunk按2^16字节对齐，大小是2^16的整数倍
+        enum EChunkHeader{ CHUNK_HEADER = 64};//chunk_header占用的字节数
+        enum EMapBits{ MAP_BITS = 16};//chunk_map每一层的位数，两层覆盖48位地址
+        enum EHugePageShift{ HUGE_PAGE_SHIFT = 21};//大页为2^21字节(x86-64、aarch64的默认大页)
+        enum EProfileDepth{ PROFILE_DEPTH = 32};//采样记录的调用栈深度
+        enum EProfileRecheck{ PROFILE_RECHECK = 1 << 20};//未开启采样时，每分配这么多字节检查一次是否已开启
+    public:
+        //内存池向操作系统申请chunk的方式
+        struct chunk_source{
+            //返回按2^16字节对齐的至少bytes字节(bytes是2^16的倍数)，可以把bytes改为实际得到的大小，失败返回0
+            void *(*map)(size_t& bytes);
+            //归还map得到的p，bytes为map时得到的大小
+            void (*unmap)(void *p, size_t bytes);
+        };
+        //线程缓存从内存池补货的策略
+        struct refill_policy{
+            //本线程上一次为bytes字节的free-list从内存池切了last个区块(第一次为0)，
+            //此后本线程其他free-list又从内存池切分了gap次，返回这次切几个(至少1个)
+            size_t (*objs)(size_t bytes, size_t last, size_t gap);
+            //内存池不够用时向chunk_source要多少字节：want是这次至少要用到的，heap_size是内存池已有的
+            size_t (*grow)(size_t want, size_t heap_size);
+        };
     private:
         //free-lists的节点构造
         union obj{
@@ -27,77 +132,912 @@ namespace tt {
             char client[1];
         };
 
-        static obj *free_list[ENFreeLists::NFREELISTS];
+        //其他线程回收的区块，多个线程push、所属线程整条取走，各占一个cache line
+        struct alignas(EMaxAlign::MAX_ALIGN) remote_queue{
+            std::atomic<obj *> head;
+        };
+
+        //线程拥有的内存池与远程回收队列；heap一经创建就不释放，线程退出后留给新线程接管
+        struct heap{
+            remote_queue remote[ENFreeLists::NFREELISTS];
+            char *start_free;  //内存池起始位置，受pool_lock保护
+            char *end_free;    //内存池结束位置，受pool_lock保护
+            std::atomic<bool> orphan;  //所属线程已经退出
+            heap *next;        //所有heap串成单链表，受pool_lock保护
+        };
+
+        //线程私有的free-lists，只被所属线程访问，无需加锁
+        struct thread_cache{
+            obj *free_list[ENFreeLists::NFREELISTS];
+            size_t length[ENFreeLists::NFREELISTS];
+            heap *home;  //本线程的heap，第一次refill时取得
+            ptrdiff_t sample_left;  //距离下一个采样点还要分配的字节数
+            size_t sample_rate;     //抽取sample_left时的采样间隔，0表示当时没有开启
+            uint64_t sample_seed;   //抽取采样间隔的随机数状态
+            size_t refill_objs[ENFreeLists::NFREELISTS];  //各free-list上一次从内存池切出的区块数
+            size_t refill_tick[ENFreeLists::NFREELISTS];  //各free-list上一次从内存池切分时的pool_refills
+            size_t pool_refills;  //本线程从内存池切分的次数
+
+            thread_cache();
+            ~thread_cache();  //线程退出时把剩余区块交还中央仓库
+        };
+
+        //中央仓库，每个free-list一把锁，以整批为单位在线程之间转移区块
+        struct central_depot{
+            std::mutex lock;
+            obj *batches[EDepotSlots::DEPOT_SLOTS];  //每一项都是恰好BATCH_OBJS(index)个区块的链表
+            size_t nbatches;
+            obj *free_list;  //零散区块：内存池的边角料、线程退出时归还的区块、放不进batches的整批
+        };
+
+        //每个chunk开头的管理信息，所有chunk串成一条双向链表
+        struct chunk_header{
+            chunk_header *prev;
+            chunk_header *next;
+            size_t size;        //整个chunk的字节数，包括chunk_header
+            size_t free_bytes;  //trim时统计的空闲字节数
+            const chunk_source *source;  //chunk来自哪个chunk_source，归还时交还给它
+            heap *owner;        //切分这个chunk的heap，回收的区块送回这里
+            std::atomic<size_t> sampled;  //chunk里仍存活的采样区块数，不为0时回收才需要查采样表
+        };
+
+        //后台定期调用trim()的线程
+        struct background_trimmer{
+            std::mutex lock;
+            std::condition_variable cv;
+            std::thread worker;
+            bool stop = false;
+
+            ~background_trimmer();
+        };
+
+        static thread_local thread_cache tcache;
+        //本线程的tcache已经析构。先于tcache构造的thread_local析构得更晚，其中还会分配、回收，
+        //此后不能再碰tcache(析构函数里对它的写入可能被编译器当作无用的写入删掉)，改走中央仓库
+        static thread_local bool tcache_dead;
+        static central_depot depot[ENFreeLists::NFREELISTS];
     private:
-        static char *start_free;  //内存池起始位置
-        static char *end_free;    //内存池结束位置
+        static std::mutex pool_lock;  //保护各heap的内存池、heap链表以及chunk链表、chunk_map
+        static heap *heaps;       //所有heap
         static size_t heap_size;  //内存池的可用大小
+        static chunk_header *chunks;  //所有chunk
+        static chunk_header **chunk_map[1 << EMapBits::MAP_BITS];  //(地址>>CHUNK_SHIFT) -> chunk，两层基数树
+        static background_trimmer trimmer;
+        static const chunk_source *chunk_src;  //新chunk的来源，受pool_lock保护
+        static const refill_policy *refill_pol;  //从内存池补货的策略，受pool_lock保护
+
+        //内存预算
+        struct pool_exhausted {};  //grow_pool在预算内得不到内存时抛出，由refill放开pool_lock之后处理
+        static std::atomic<size_t> footprint_bytes;  //chunk与超过MAXBYTES的区块共占用的字节数
+        static std::atomic<size_t> soft_budget;  //0表示不限制
+        static std::atomic<size_t> hard_budget;
+        static std::atomic<bool> pressure_pending;  //footprint越过了软上限，等放开pool_lock后通知
+        static std::atomic<bool> above_soft;        //已经通知过，回到软上限以下之前不再通知
+        static std::atomic<void (*)()> oom;
+        static std::mutex handler_lock;  //保护pressure_handlers()
+        static std::vector<void (*)(size_t, size_t)>& pressure_handlers(){
+            static std::vector<void (*)(size_t, size_t)> *handlers = new std::vector<void (*)(size_t, size_t)>();
+            return *handlers;
+        }
+        //footprint将增加bytes：超过硬上限时不计入并返回false
+        static bool charge(size_t bytes);
+        static void uncharge(size_t bytes);
+        //依次调用pressure handler并trim()，调用时不能持有pool_lock
+        static void relieve_pressure();
+        //第attempt次(从0开始)在预算内得不到内存：第一次先relieve_pressure()，之后每次调用oom handler，
+        //没有oom handler时抛出std::bad_alloc
+        static void handle_out_of_memory(int attempt);
+        //超过MAXBYTES的区块，align为0时用malloc
+        static void *large_allocate(size_t bytes, size_t align);
+        static void large_deallocate(void *ptr, size_t bytes);
     private:
         //将bytes上调至8的倍数
         static size_t ROUND_UP(size_t bytes){
             return ((bytes + EAlign::ALIGN - 1) & ~(EAlign::ALIGN - 1));
         }
+        //将bytes上调至chunk对齐边界的倍数
+        static size_t CHUNK_ROUND_UP(size_t bytes){
+            return ((bytes + ((size_t)1 << EChunkShift::CHUNK_SHIFT) - 1) & ~(((size_t)1 << EChunkShift::CHUNK_SHIFT) - 1));
+        }
+        //将bytes上调至页的倍数
+        static size_t PAGE_ROUND_UP(size_t bytes){
+            return ((bytes + EPageSize::PAGE_SIZE - 1) & ~(size_t)(EPageSize::PAGE_SIZE - 1));
+        }
         //根据区块大小，决定使用第n号free-list，n从0开始计算
         static size_t FREELIST_INDEX(size_t bytes){
-            return (((bytes)+EAlign::ALIGN - 1) / EAlign::ALIGN - 1);
+            if (bytes <= EMaxSmallBytes::MAXSMALLBYTES){
+                return (((bytes)+EAlign::ALIGN - 1) / EAlign::ALIGN - 1);
+            }
+            size_t shift = ESmallShift::SMALL_SHIFT;  //bytes落在(2^shift, 2^(shift+1)]
+            while (((size_t)2 << shift) < bytes){
+                ++shift;
+            }
+            size_t step = ((size_t)1 << shift) / EClassesPerDoubling::CLASSES_PER_DOUBLING;
+            return ENSmallLists::NSMALLLISTS + (shift - ESmallShift::SMALL_SHIFT) * EClassesPerDoubling::CLASSES_PER_DOUBLING
+                   + (bytes - ((size_t)1 << shift) + step - 1) / step - 1;
+        }
+        //第index号free-list的区块大小
+        static size_t CLASS_SIZE(size_t index){
+            if (index < ENSmallLists::NSMALLLISTS){
+                return (index + 1) * EAlign::ALIGN;
+            }
+            index -= ENSmallLists::NSMALLLISTS;
+            size_t base = (size_t)1 << (ESmallShift::SMALL_SHIFT + index / EClassesPerDoubling::CLASSES_PER_DOUBLING);
+            return base + (index % EClassesPerDoubling::CLASSES_PER_DOUBLING + 1) * (base / EClassesPerDoubling::CLASSES_PER_DOUBLING);
+        }
+        //大小为bytes的区块能保证的对齐：bytes的最低位，最多MAX_ALIGN
+        static size_t NATURAL_ALIGN(size_t bytes){
+            size_t align = bytes & (~bytes + 1);
+            return align > EMaxAlign::MAX_ALIGN ? (size_t)EMaxAlign::MAX_ALIGN : align;
+        }
+        //能放下bytes字节且按align对齐的最小free-list，返回NFREELISTS表示要交给malloc
+        static size_t ALIGNED_INDEX(size_t bytes, size_t align){
+            if (align > EMaxAlign::MAX_ALIGN){
+                return ENFreeLists::NFREELISTS;
+            }
+            bytes = (bytes + align - 1) & ~(align - 1);
+            if (bytes > EMaxBytes::MAXBYTES){
+                return ENFreeLists::NFREELISTS;
+            }
+            size_t index = FREELIST_INDEX(bytes);
+            while (index < ENFreeLists::NFREELISTS && NATURAL_ALIGN(CLASS_SIZE(index)) < align){
+                ++index;
+            }
+            return index;
         }
-        //返回一个大小为n的对象，并可能加入大小为n的其他区块到free-list
-        static void *refill(size_t n);
-        //配置一大块空间，可容纳nobjs个大小为size的区块
+        //线程缓存里第index号free-list攒到多少个区块以上时交一批给中央仓库
+        //刚从内存池切了一大批的热点free-list多留一些，不然切来的区块马上又被交出去
+        static size_t CACHE_LIMIT(const thread_cache& cache, size_t index){
+            return 2 * BATCH_OBJS(index) + cache.refill_objs[index];
+        }
+        //第index号free-list每次与中央仓库之间每批搬运的区块数，也是fixed_refill每次切出的区块数
+        static size_t BATCH_OBJS(size_t index){
+            if (index < ENSmallLists::NSMALLLISTS){
+                return ENObjs::NOBJS;
+            }
+            size_t n = ERunBytes::RUN_BYTES / CLASS_SIZE(index);
+            return n < 2 ? 2 : (n > ENObjs::NOBJS ? (size_t)ENObjs::NOBJS : n);
+        }
+        //返回一个大小为n的对象，并可能加入大小为n的其他区块到cache的free-list
+        static void *refill(thread_cache& cache, size_t n);
+        //tcache析构之后的分配与回收：分配借一个临时的线程缓存，它析构时交还多余的区块和heap；
+        //回收的区块所属heap还有线程在用就送回去，否则交给中央仓库
+        static void *allocate_after_exit(size_t bytes);
+        static void deallocate_after_exit(heap *owner, size_t index, obj *node){
+            if (!owner->orphan.load(std::memory_order_relaxed)){
+                push_remote(owner, index, node, node, 1);
+            }
+            else{
+                push_to_depot(index, node, node);
+            }
+        }
+        //从h的内存池配置一大块空间，可容纳nobjs个大小为size的区块
         //如果配置nobjs个区块有所不便，nobjs可能会降低
-        static char *chunk_alloc(size_t size, size_t& nobjs);
+        //调用者必须持有pool_lock
+        static char *chunk_alloc(heap& h, size_t size, size_t& nobjs);
+        //从h的内存池切出一段按页对齐、长度为bytes(页的倍数)的连续页，供中型区块切分
+        //调用者必须持有pool_lock
+        static char *page_run_alloc(heap& h, size_t bytes);
+        //h的内存池不够用时申请新chunk，期望得到want个字节，至少要能提供need个字节
+        //调用者必须持有pool_lock
+        static void grow_pool(heap& h, size_t want, size_t need);
+        //把[p, p + n)切成尽量大、且满足对齐约定的区块挂到中央仓库，n必须是8的倍数
+        static void carve_to_depot(char *p, size_t n);
+
+        //从线程缓存的第index号free-list摘下一整批交给中央仓库
+        static void release_batch(thread_cache& cache, size_t index);
+        //从中央仓库取回至多一整批区块，返回链表头，n为取到的个数
+        static obj *fetch_batch(size_t index, size_t& n);
+        //把一条以tail结尾的链表挂到中央仓库的零散区块上
+        static void push_to_depot(size_t index, obj *head, obj *tail);
+        //把线程缓存里的区块全部交还中央仓库
+        static void flush_thread_cache(thread_cache& cache);
+
+        //取得本线程的heap：优先接管孤儿heap，没有就新建一个
+        static heap& home_heap(thread_cache& cache);
+        //线程退出时交出heap：内存池剩余部分和远程回收队列交给中央仓库，标记为孤儿
+        static void release_heap(heap& h);
+        //把[first, last]这一段共n个区块放进owner的远程回收队列
+        static void push_remote(heap *owner, size_t index, obj *first, obj *last, size_t n){
+            std::atomic<obj *>& head = owner->remote[index].head;
+            obj *old = head.load(std::memory_order_relaxed);
+            do{
+                last->next = old;
+            } while (!head.compare_exchange_weak(old, first, std::memory_order_release, std::memory_order_relaxed));
+            TINYSTL_ALLOC_STAT(remote_frees.fetch_add(n, std::memory_order_relaxed));
+            (void)n;  //只有开启统计时才用到
+        }
+        //整条取走h的第index号远程回收队列
+        static obj *drain_remote(heap& h, size_t index){
+            if (!h.remote[index].head.load(std::memory_order_relaxed)){
+                return 0;
+            }
+            return h.remote[index].head.exchange(0, std::memory_order_acquire);
+        }
+
+        //chunk的登记、注销与查找，调用者必须持有pool_lock
+        static bool register_chunk(chunk_header *chunk);
+        static void unregister_chunk(chunk_header *chunk);
+        static chunk_header *chunk_of(const void *ptr);
+        static bool chunk_idle(const chunk_header *chunk){
+            return chunk->free_bytes == chunk->size - EChunkHeader::CHUNK_HEADER;
+        }
+        //把[first, last)中整页的部分交还操作系统，内容变为未定义
+        static void purge_pages(char *first, char *last);
+
+        //可以用于任意指针的chunk_of，不在内存池里时返回0
+        static chunk_header *find_chunk(const void *ptr){
+            uintptr_t key = (uintptr_t)ptr >> EChunkShift::CHUNK_SHIFT;
+            chunk_header **leaf = chunk_map[key >> EMapBits::MAP_BITS];
+            return leaf ? leaf[key & ((1 << EMapBits::MAP_BITS) - 1)] : 0;
+        }
+
+        //采样式堆剖析
+        //同一调用栈上的采样汇总
+        struct profile_bucket{
+            size_t alloc_count;  //累计采样的分配次数
+            size_t alloc_bytes;
+            size_t inuse_count;  //仍存活的采样数
+            size_t inuse_bytes;
+        };
+        //仍存活的一个采样
+        struct live_sample{
+            profile_bucket *bucket;
+            size_t bytes;
+            chunk_header *chunk;  //所在chunk，超过MAXBYTES由malloc分配的为0
+        };
+        struct profile_data{
+            std::mutex lock;
+            size_t rate;  //最近一次开启时的采样间隔，输出时写进文件头
+            std::map<std::vector<void *>, profile_bucket> buckets;  //调用栈 -> 汇总
+            std::unordered_map<void *, live_sample> live;
+        };
+        static std::atomic<size_t> sample_rate;  //0表示不采样
+        static std::atomic<size_t> large_samples;  //仍存活的、由malloc分配的采样数
+        //采样表只在采样、回收采样区块、输出时使用，第一次用到时创建且不释放，避免退出时的析构顺序问题
+        static profile_data& profile(){
+            static profile_data *data = new profile_data();
+            return *data;
+        }
+        //分配累计越过采样点时调用：按当前采样间隔记录ptr，并抽取下一个采样点
+        static void sample_allocation(thread_cache& cache, void *ptr, size_t bytes);
+        //记录ptr的调用栈
+        static void record_sample(void *ptr, size_t bytes);
+        //ptr可能是采样区块，回收时从采样表中去掉
+        static void forget_sample(void *ptr);
+        //均值为rate的指数分布，使采样点在分配的字节流上近似泊松分布
+        static ptrdiff_t next_sample_interval(thread_cache& cache, size_t rate);
+
+        //两种内置refill_policy的实现
+        static size_t adaptive_objs(size_t bytes, size_t last, size_t gap);
+        static size_t adaptive_grow(size_t want, size_t heap_size);
+        static size_t fixed_objs(size_t bytes, size_t last, size_t gap);
+        static size_t fixed_grow(size_t want, size_t heap_size);
+
+        //两种内置chunk_source的实现
+        static void *malloc_chunk_map(size_t& bytes);
+        static void malloc_chunk_unmap(void *p, size_t bytes);
+        static void *huge_chunk_map(size_t& bytes);
+        static void huge_chunk_unmap(void *p, size_t bytes);
+
+#ifdef TINYSTL_ALLOC_STATS
+        //每个free-list的计数器，各线程共享，使用relaxed原子操作
+        struct class_counters{
+            std::atomic<size_t> allocations;
+            std::atomic<size_t> frees;
+            std::atomic<size_t> refills;
+            std::atomic<size_t> live;        //尚未归还的区块数
+            std::atomic<size_t> high_water;  //live的历史最大值
+        };
+        static class_counters class_stats[ENFreeLists::NFREELISTS];
+        static std::atomic<size_t> large_allocations;  //超过MAXBYTES、直接交给malloc的分配次数
+        static std::atomic<size_t> large_frees;
+        static std::atomic<size_t> large_bytes;        //尚未归还的大块字节数
+        static std::atomic<size_t> pool_grows;         //内存池不够用、向malloc要新chunk的次数
+        static std::atomic<size_t> remote_frees;       //回收到其他线程heap的区块数
+        static std::atomic<size_t> bytes_outstanding;  //所有尚未归还的字节数(按区块大小计)
+        static std::atomic<size_t> high_water;         //bytes_outstanding的历史最大值
+
+        static void raise_high_water(std::atomic<size_t>& mark, size_t value){
+            size_t old = mark.load(std::memory_order_relaxed);
+            while (old < value && !mark.compare_exchange_weak(old, value, std::memory_order_relaxed)){}
+        }
+        //n个大小为bytes的区块
+        static void stat_allocate(size_t index, size_t bytes, size_t n = 1){
+            class_counters& c = class_stats[index];
+            c.allocations.fetch_add(n, std::memory_order_relaxed);
+            raise_high_water(c.high_water, c.live.fetch_add(n, std::memory_order_relaxed) + n);
+            raise_high_water(high_water, bytes_outstanding.fetch_add(bytes * n, std::memory_order_relaxed) + bytes * n);
+        }
+        static void stat_deallocate(size_t index, size_t bytes, size_t n = 1){
+            class_counters& c = class_stats[index];
+            c.frees.fetch_add(n, std::memory_order_relaxed);
+            c.live.fetch_sub(n, std::memory_order_relaxed);
+            bytes_outstanding.fetch_sub(bytes * n, std::memory_order_relaxed);
+        }
+        static void stat_large_allocate(size_t bytes){
+            large_allocations.fetch_add(1, std::memory_order_relaxed);
+            large_bytes.fetch_add(bytes, std::memory_order_relaxed);
+            raise_high_water(high_water, bytes_outstanding.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+        }
+        static void stat_large_deallocate(size_t bytes){
+            large_frees.fetch_add(1, std::memory_order_relaxed);
+            large_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+            bytes_outstanding.fetch_sub(bytes, std::memory_order_relaxed);
+        }
+#endif
 
     public:
+        //aligned_alloc/free，默认使用
+        static const chunk_source malloc_source;
+        //mmap出按2MB对齐、大小为2MB倍数的内存：优先MAP_HUGETLB预留的大页，
+        //没有预留大页时用madvise(MADV_HUGEPAGE)请求透明大页，都不支持时就是普通的4K页
+        static const chunk_source huge_page_source;
+        //按本线程各free-list的缺货频率指数增减批量，默认使用
+        static const refill_policy adaptive_refill;
+        //固定批量：小型区块每次20个，中型区块每次约64KB；内存池按已有大小的1/16增长
+        static const refill_policy fixed_refill;
+        //之后的补货改用policy；policy必须一直有效
+        static void set_refill_policy(const refill_policy& policy);
+        //内存不足时的回调：footprint是当前占用，budget是越过的软上限
+        typedef void (*pressure_handler)(size_t footprint, size_t budget);
+        typedef void (*oom_handler)();
+        //soft、hard为0表示不限制，soft应不大于hard
+        static void set_memory_budget(size_t soft, size_t hard);
+        //pressure handler应当释放自己缓存的内存；调用时不持有alloc的任何锁，可以回收区块
+        static void add_pressure_handler(pressure_handler handler);
+        static void remove_pressure_handler(pressure_handler handler);
+        //handler应当释放一些内存、换一个handler，或者抛出异常、结束进程；返回原来的handler
+        static oom_handler set_oom_handler(oom_handler handler);
+        //chunk与超过MAXBYTES的区块共占用的字节数，预算与它比较
+        static size_t footprint();
+        //之后新申请的chunk改用source，已有的chunk仍归还给各自的来源；source必须一直有效
+        static void set_chunk_source(const chunk_source& source);
+
+        //stats()返回的快照
+        struct stats_snapshot{
+            struct size_class{
+                size_t bytes;              //区块大小
+                size_t allocations;
+                size_t frees;
+                size_t refills;            //线程缓存缺货的次数
+                size_t bytes_outstanding;  //尚未归还的字节数
+                size_t high_water;         //bytes_outstanding的历史最大值
+            };
+            bool enabled;  //是否定义了TINYSTL_ALLOC_STATS
+            size_t nclasses;
+            size_class classes[ENFreeLists::NFREELISTS];
+            size_t large_allocations;
+            size_t large_frees;
+            size_t large_bytes_outstanding;
+            size_t pool_grows;
+            size_t remote_frees;  //回收到其他线程heap的区块数
+            size_t heap_size;
+            size_t bytes_outstanding;
+            size_t high_water;
+        };
+
         static void *allocate(size_t bytes);
         static void deallocate(void *ptr, size_t bytes);
+        //按align(2的幂)对齐分配，回收时必须传入同样的bytes和align
+        static void *allocate(size_t bytes, size_t align);
+        static void deallocate(void *ptr, size_t bytes, size_t align);
+        //把ptr处old_sz字节的区块调整为new_sz字节，内容保留min(old_sz, new_sz)字节：
+        //新旧大小落在同一个free-list时原样返回ptr；都超过MAXBYTES时交给realloc，
+        //由它原地扩展或对mmap出来的大块使用mremap；其余情况分配新区块并拷贝
+        //ptr为0时相当于allocate(new_sz)；new_sz为0时回收ptr并返回0
+        //失败时返回0，原区块保持不变
         static void *reallocate(void *ptr, size_t old_sz, size_t new_sz);
+        //一次分配n个bytes字节的区块放进out[0, n)，直接从线程缓存摘下整段，缺货时才refill
+        static void allocate_batch(size_t bytes, size_t n, void **out);
+        //一次回收ptrs[0, n)中的n个区块，属于同一个别的线程的连续区块一次送回
+        static void deallocate_batch(void **ptrs, size_t n, size_t bytes);
+        //按align对齐的版本，回收时必须传入同样的bytes和align
+        static void allocate_batch(size_t bytes, size_t n, void **out, size_t align);
+        static void deallocate_batch(void **ptrs, size_t n, size_t bytes, size_t align);
+
+        //把所有区块都空闲的chunk还给操作系统，并对仍在使用的chunk里整页空闲的部分调用madvise
+        //只能看到中央仓库、各heap远程回收队列和当前线程缓存里的空闲区块，其他线程缓存中的区块视为在使用
+        //返回释放的chunk字节数
+        static size_t trim();
+        //启动一个后台线程，每隔interval调用一次trim()；重复调用会以新的间隔重启
+        static void start_background_trim(std::chrono::milliseconds interval);
+        static void stop_background_trim();
+
+        //统计信息的快照，各计数器分别读取，不保证彼此严格一致
+        static stats_snapshot stats();
+        //以文本或JSON格式输出stats()
+        static void dump_stats(std::ostream& out, bool json = false);
+
+        //采样式堆剖析：平均每分配rate字节记录一次调用栈，0表示关闭(默认)
+        //关闭时分配只多一次减法和比较；开启后回收只有所在chunk含有采样区块时才需要加锁查表
+        static void set_profile_sample_rate(size_t rate);
+        //按调用栈汇总仍存活的采样，以gperftools的堆剖析格式(heap_v2)输出，可以直接交给pprof
+        //计数是采样数，pprof根据文件头的采样间隔换算成估计值；栈顶几帧是tt::alloc自身
+        static void dump_heap_profile(std::ostream& out);
     };
 
-    char *alloc::start_free = 0;
-    char *alloc::end_free = 0;
+    std::mutex alloc::pool_lock;
+    alloc::heap *alloc::heaps = 0;
     size_t alloc::heap_size = 0;
+    alloc::chunk_header *alloc::chunks = 0;
+    alloc::chunk_header **alloc::chunk_map[1 << alloc::EMapBits::MAP_BITS] = {};
+    alloc::background_trimmer alloc::trimmer;
+    const alloc::chunk_source alloc::malloc_source = { &alloc::malloc_chunk_map, &alloc::malloc_chunk_unmap };
+    const alloc::chunk_source alloc::huge_page_source = { &alloc::huge_chunk_map, &alloc::huge_chunk_unmap };
+    const alloc::chunk_source *alloc::chunk_src = &alloc::malloc_source;
+    const alloc::refill_policy alloc::adaptive_refill = { &alloc::adaptive_objs, &alloc::adaptive_grow };
+    const alloc::refill_policy alloc::fixed_refill = { &alloc::fixed_objs, &alloc::fixed_grow };
+    const alloc::refill_policy *alloc::refill_pol = &alloc::adaptive_refill;
+    std::atomic<size_t> alloc::footprint_bytes(0);
+    std::atomic<size_t> alloc::soft_budget(0);
+    std::atomic<size_t> alloc::hard_budget(0);
+    std::atomic<bool> alloc::pressure_pending(false);
+    std::atomic<bool> alloc::above_soft(false);
+    std::atomic<void (*)()> alloc::oom(0);
+    std::mutex alloc::handler_lock;
+    std::atomic<size_t> alloc::sample_rate(0);
+    std::atomic<size_t> alloc::large_samples(0);
+#ifdef TINYSTL_ALLOC_STATS
+    alloc::class_counters alloc::class_stats[alloc::ENFreeLists::NFREELISTS];
+    std::atomic<size_t> alloc::large_allocations(0);
+    std::atomic<size_t> alloc::large_frees(0);
+    std::atomic<size_t> alloc::large_bytes(0);
+    std::atomic<size_t> alloc::pool_grows(0);
+    std::atomic<size_t> alloc::remote_frees(0);
+    std::atomic<size_t> alloc::bytes_outstanding(0);
+    std::atomic<size_t> alloc::high_water(0);
+#endif
 
-    alloc::obj *alloc::free_list[alloc::ENFreeLists::NFREELISTS] = {
-            0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
-    };
+    thread_local alloc::thread_cache alloc::tcache;
+    thread_local bool alloc::tcache_dead = false;
+    alloc::central_depot alloc::depot[alloc::ENFreeLists::NFREELISTS];
+
+    alloc::thread_cache::thread_cache(){
+        for (size_t i = 0; i < ENFreeLists::NFREELISTS; ++i){
+            free_list[i] = 0;
+            length[i] = 0;
+            refill_objs[i] = 0;
+            refill_tick[i] = 0;
+        }
+        pool_refills = 0;
+        home = 0;
+        sample_left = 0;
+        sample_rate = 0;
+        sample_seed = (uint64_t)(uintptr_t)this | 1;
+    }
+    alloc::thread_cache::~thread_cache(){
+        flush_thread_cache(*this);
+        if (home){
+            release_heap(*home);
+        }
+        tcache_dead = true;  //allocate_after_exit里的临时线程缓存析构时也会设置，那时本来就是true
+    }
+    alloc::background_trimmer::~background_trimmer(){
+        stop_background_trim();
+    }
 
     void *alloc::allocate(size_t bytes){
+        if (tcache_dead){
+            return allocate_after_exit(bytes);
+        }
+        thread_cache& cache = tcache;
+        void *result;
+        //统计在分配成功之后再记，refill、large_allocate可能抛出bad_alloc
         if (bytes > EMaxBytes::MAXBYTES){
-            return malloc(bytes);
+            result = large_allocate(bytes, 0);
+            TINYSTL_ALLOC_STAT(stat_large_allocate(bytes));
         }
-        size_t index = FREELIST_INDEX(bytes);
-        obj *list = free_list[index];
-        if (list){//此list还有空间给我们
-            free_list[index] = list->next;
-            return list;
+        else{
+            size_t index = FREELIST_INDEX(bytes);
+            obj *list = cache.free_list[index];
+            if (list){//此list还有空间给我们
+                cache.free_list[index] = list->next;
+                --cache.length[index];
+                result = list;
+            }
+            else{	//此list没有足够的空间，需要从中央仓库或内存池里面取空间
+                result = refill(cache, CLASS_SIZE(index));
+            }
+            TINYSTL_ALLOC_STAT(stat_allocate(index, CLASS_SIZE(index)));
         }
-        else{	//此list没有足够的空间，需要从内存池里面取空间
-            return refill(ROUND_UP(bytes));
+        if ((cache.sample_left -= (ptrdiff_t)bytes) < 0){//越过了采样点
+            sample_allocation(cache, result, bytes);
         }
+        return result;
     }
     void alloc::deallocate(void *ptr, size_t bytes){
         if (bytes > EMaxBytes::MAXBYTES){
-            free(ptr);
+            TINYSTL_ALLOC_STAT(stat_large_deallocate(bytes));
+            if (large_samples.load(std::memory_order_relaxed)){
+                forget_sample(ptr);
+            }
+            large_deallocate(ptr, bytes);
         }
         else{
             size_t index = FREELIST_INDEX(bytes);
+            TINYSTL_ALLOC_STAT(stat_deallocate(index, CLASS_SIZE(index)));
             obj *node = static_cast<obj *>(ptr);
-            node->next = free_list[index];
-            free_list[index] = node;
+            chunk_header *chunk = chunk_of(ptr);
+            if (chunk->sampled.load(std::memory_order_relaxed)){
+                forget_sample(ptr);
+            }
+            heap *owner = chunk->owner;
+            if (tcache_dead){
+                deallocate_after_exit(owner, index, node);
+                return;
+            }
+            thread_cache& cache = tcache;
+            if (owner != cache.home && !owner->orphan.load(std::memory_order_relaxed)){//别的线程的区块，送回去
+                push_remote(owner, index, node, node, 1);
+                return;
+            }
+            node->next = cache.free_list[index];
+            cache.free_list[index] = node;
+            //线程缓存里攒了两批以上，交一批给中央仓库，让别的线程可以取用
+            if (++cache.length[index] > CACHE_LIMIT(cache, index)){
+                release_batch(cache, index);
+            }
         }
     }
+    void *alloc::allocate(size_t bytes, size_t align){
+        if (align <= EAlign::ALIGN){
+            return allocate(bytes);
+        }
+        size_t index = ALIGNED_INDEX(bytes, align);
+        if (index == ENFreeLists::NFREELISTS){
+            void *result = large_allocate(bytes, align);
+            TINYSTL_ALLOC_STAT(stat_large_allocate(bytes));
+            if (!tcache_dead){
+                thread_cache& cache = tcache;
+                if ((cache.sample_left -= (ptrdiff_t)bytes) < 0){
+                    sample_allocation(cache, result, bytes);
+                }
+            }
+            return result;
+        }
+        return allocate(CLASS_SIZE(index));
+    }
+    void alloc::deallocate(void *ptr, size_t bytes, size_t align){
+        if (align <= EAlign::ALIGN){
+            deallocate(ptr, bytes);
+            return;
+        }
+        size_t index = ALIGNED_INDEX(bytes, align);
+        if (index == ENFreeLists::NFREELISTS){
+            TINYSTL_ALLOC_STAT(stat_large_deallocate(bytes));
+            if (large_samples.load(std::memory_order_relaxed)){
+                forget_sample(ptr);
+            }
+            large_deallocate(ptr, bytes);
+            return;
+        }
+        deallocate(ptr, CLASS_SIZE(index));
+    }
     void *alloc::reallocate(void *ptr, size_t old_sz, size_t new_sz){
-        deallocate(ptr, old_sz);
-        ptr = allocate(new_sz);
+        if (new_sz == 0){//FREELIST_INDEX(0)会下溢，按realloc(ptr, 0)的习惯直接回收
+            if (ptr){
+                deallocate(ptr, old_sz);
+            }
+            return 0;
+        }
+        if (!ptr){
+            try{
+                return allocate(new_sz);
+            }
+            catch (const std::bad_alloc&){
+                return 0;
+            }
+        }
+        if (old_sz <= EMaxBytes::MAXBYTES && new_sz <= EMaxBytes::MAXBYTES){
+            if (FREELIST_INDEX(old_sz) == FREELIST_INDEX(new_sz)){//同一个free-list，区块本身就够大
+                return ptr;
+            }
+        }
+        else if (old_sz > EMaxBytes::MAXBYTES && new_sz > EMaxBytes::MAXBYTES){
+            if (large_samples.load(std::memory_order_relaxed)){//realloc之后旧地址可能马上被别人用到，先去掉
+                forget_sample(ptr);
+            }
+            if (new_sz > old_sz && !charge(new_sz - old_sz)){
+                return 0;
+            }
+            void *result = realloc(ptr, new_sz);
+            if (result){
+                TINYSTL_ALLOC_STAT(stat_large_deallocate(old_sz));
+                TINYSTL_ALLOC_STAT(stat_large_allocate(new_sz));
+                if (new_sz < old_sz){
+                    uncharge(old_sz - new_sz);
+                }
+            }
+            else if (new_sz > old_sz){
+                uncharge(new_sz - old_sz);
+            }
+            return result;
+        }
+        void *result = 0;
+        try{
+            result = allocate(new_sz);
+        }
+        catch (const std::bad_alloc&){
+            return 0;
+        }
+        if (result){
+            memcpy(result, ptr, old_sz < new_sz ? old_sz : new_sz);
+            deallocate(ptr, old_sz);
+        }
+        return result;
+    }
+    void alloc::allocate_batch(size_t bytes, size_t n, void **out){
+        if (bytes > EMaxBytes::MAXBYTES || tcache_dead){//大区块或者tcache已经析构时逐个处理
+            size_t i = 0;
+            try{
+                for (; i < n; ++i){
+                    out[i] = allocate(bytes);
+                }
+            }
+            catch (...){//整批要么全部成功，要么什么也没分配
+                deallocate_batch(out, i, bytes);
+                throw;
+            }
+            return;
+        }
+        size_t index = FREELIST_INDEX(bytes);
+        thread_cache& cache = tcache;
+        size_t i = 0;
+        try{
+            while (i < n){
+                obj *list = cache.free_list[index];
+                if (!list){//线程缓存空了，refill返回一个区块并补满线程缓存
+                    out[i++] = refill(cache, CLASS_SIZE(index));
+                    continue;
+                }
+                size_t taken = 0;
+                for (; i < n && list; ++i, ++taken){
+                    out[i] = list;
+                    list = list->next;
+                }
+                cache.free_list[index] = list;
+                cache.length[index] -= taken;
+            }
+        }
+        catch (...){//refill抛出异常：已经取到的区块还没有计入统计，直接放回线程缓存
+            for (size_t j = 0; j < i; ++j){
+                obj *node = static_cast<obj *>(out[j]);
+                node->next = cache.free_list[index];
+                cache.free_list[index] = node;
+            }
+            cache.length[index] += i;
+            throw;
+        }
+        TINYSTL_ALLOC_STAT(stat_allocate(index, CLASS_SIZE(index), n));
+        if (cache.sample_left >= (ptrdiff_t)(bytes * n)){//整批没有越过采样点，一次减掉
+            cache.sample_left -= (ptrdiff_t)(bytes * n);
+        }
+        else{//逐个找出越过采样点的区块，一批可能越过好几个，与逐个allocate采到的一样
+            for (size_t j = 0; j < n; ++j){
+                if ((cache.sample_left -= (ptrdiff_t)bytes) < 0){
+                    sample_allocation(cache, out[j], bytes);
+                }
+            }
+        }
+    }
+    void alloc::deallocate_batch(void **ptrs, size_t n, size_t bytes){
+        if (bytes > EMaxBytes::MAXBYTES || tcache_dead){//大区块或者tcache已经析构时逐个处理
+            for (size_t i = 0; i < n; ++i){
+                deallocate(ptrs[i], bytes);
+            }
+            return;
+        }
+        size_t index = FREELIST_INDEX(bytes);
+        TINYSTL_ALLOC_STAT(stat_deallocate(index, CLASS_SIZE(index), n));
+        thread_cache& cache = tcache;
+        heap *remote_owner = 0;  //正在攒的一段属于哪个heap
+        obj *remote = 0, *remote_tail = 0;
+        size_t nremote = 0;
+        for (size_t i = 0; i < n; ++i){
+            obj *node = static_cast<obj *>(ptrs[i]);
+            chunk_header *chunk = chunk_of(node);
+            if (chunk->sampled.load(std::memory_order_relaxed)){
+                forget_sample(node);
+            }
+            heap *owner = chunk->owner;
+            if (owner != cache.home && !owner->orphan.load(std::memory_order_relaxed)){
+                if (owner != remote_owner){
+                    if (remote){
+                        push_remote(remote_owner, index, remote, remote_tail, nremote);
+                    }
+                    remote_owner = owner;
+                    remote = remote_tail = 0;
+                    nremote = 0;
+                }
+                node->next = remote;
+                remote = node;
+                if (!remote_tail){
+                    remote_tail = node;
+                }
+                ++nremote;
+                continue;
+            }
+            //与逐个deallocate的顺序相同，free-list里相邻的区块在内存里也相邻，之后整批分配时局部性更好
+            node->next = cache.free_list[index];
+            cache.free_list[index] = node;
+            if (++cache.length[index] > CACHE_LIMIT(cache, index)){
+                release_batch(cache, index);
+            }
+        }
+        if (remote){
+            push_remote(remote_owner, index, remote, remote_tail, nremote);
+        }
+    }
+    void alloc::allocate_batch(size_t bytes, size_t n, void **out, size_t align){
+        if (align <= EAlign::ALIGN){
+            allocate_batch(bytes, n, out);
+            return;
+        }
+        size_t index = ALIGNED_INDEX(bytes, align);
+        if (index == ENFreeLists::NFREELISTS){
+            size_t i = 0;
+            try{
+                for (; i < n; ++i){
+                    out[i] = allocate(bytes, align);
+                }
+            }
+            catch (...){
+                deallocate_batch(out, i, bytes, align);
+                throw;
+            }
+            return;
+        }
+        allocate_batch(CLASS_SIZE(index), n, out);
+    }
+    void alloc::deallocate_batch(void **ptrs, size_t n, size_t bytes, size_t align){
+        if (align <= EAlign::ALIGN){
+            deallocate_batch(ptrs, n, bytes);
+            return;
+        }
+        size_t index = ALIGNED_INDEX(bytes, align);
+        if (index == ENFreeLists::NFREELISTS){
+            for (size_t i = 0; i < n; ++i){
+                deallocate(ptrs[i], bytes, align);
+            }
+            return;
+        }
+        deallocate_batch(ptrs, n, CLASS_SIZE(index));
+    }
+    void alloc::release_batch(thread_cache& cache, size_t index){
+        size_t batch = BATCH_OBJS(index);
+        obj *head = cache.free_list[index];
+        obj *tail = head;
+        for (size_t i = 1; i < batch; ++i){
+            tail = tail->next;
+        }
+        cache.free_list[index] = tail->next;
+        cache.length[index] -= batch;
+        tail->next = 0;
 
-        return ptr;
+        central_depot& d = depot[index];
+        std::lock_guard<std::mutex> guard(d.lock);
+        if (d.nbatches < EDepotSlots::DEPOT_SLOTS){
+            d.batches[d.nbatches++] = head;
+        }
+        else{
+            tail->next = d.free_list;
+            d.free_list = head;
+        }
+    }
+    alloc::obj *alloc::fetch_batch(size_t index, size_t& n){
+        size_t batch = BATCH_OBJS(index);
+        central_depot& d = depot[index];
+        std::lock_guard<std::mutex> guard(d.lock);
+        if (d.nbatches > 0){//有整批，O(1)取走
+            n = batch;
+            return d.batches[--d.nbatches];
+        }
+        obj *head = d.free_list;
+        if (!head){
+            n = 0;
+            return 0;
+        }
+        obj *tail = head;
+        for (n = 1; n < batch && tail->next; ++n){
+            tail = tail->next;
+        }
+        d.free_list = tail->next;
+        tail->next = 0;
+        return head;
+    }
+    void alloc::push_to_depot(size_t index, obj *head, obj *tail){
+        central_depot& d = depot[index];
+        std::lock_guard<std::mutex> guard(d.lock);
+        tail->next = d.free_list;
+        d.free_list = head;
+    }
+    void alloc::flush_thread_cache(thread_cache& cache){
+        for (size_t i = 0; i < ENFreeLists::NFREELISTS; ++i){
+            obj *head = cache.free_list[i];
+            if (head){
+                obj *tail = head;
+                while (tail->next){
+                    tail = tail->next;
+                }
+                push_to_depot(i, head, tail);
+                cache.free_list[i] = 0;
+                cache.length[i] = 0;
+            }
+        }
+    }
+    void alloc::carve_to_depot(char *p, size_t n){
+        while (n >= EAlign::ALIGN){
+            size_t index = n > EMaxBytes::MAXBYTES ? ENFreeLists::NFREELISTS - 1 : FREELIST_INDEX(n);
+            //放得下、并且p满足该free-list对齐约定的最大区块，最差退到8字节
+            while (CLASS_SIZE(index) > n || ((uintptr_t)p & (NATURAL_ALIGN(CLASS_SIZE(index)) - 1))){
+                --index;
+            }
+            size_t bytes = CLASS_SIZE(index);
+            push_to_depot(index, (obj *)p, (obj *)p);
+            p += bytes;
+            n -= bytes;
+        }
     }
     //返回一个大小为n的对象，并且有时候会为适当的free list增加节点
-    //假设bytes已经上调为8的倍数
-    void *alloc::refill(size_t bytes){
-        size_t nobjs = ENObjs::NOBJS;
+    //假设bytes已经是某个free-list的区块大小
+    void *alloc::refill(thread_cache& cache, size_t bytes){
+        size_t index = FREELIST_INDEX(bytes);
+        TINYSTL_ALLOC_STAT(class_stats[index].refills.fetch_add(1, std::memory_order_relaxed));
+        heap& h = home_heap(cache);
+        //先收回其他线程还给本线程的区块
+        obj *remote = drain_remote(h, index);
+        if (remote){
+            size_t n = 0;
+            for (obj *p = remote->next; p; p = p->next){
+                ++n;
+            }
+            cache.free_list[index] = remote->next;
+            cache.length[index] = n;
+            return remote;
+        }
+        //再向中央仓库要一批
+        size_t nobjs = 0;
+        obj *batch = fetch_batch(index, nobjs);
+        if (batch){
+            cache.free_list[index] = batch->next;
+            cache.length[index] = nobjs - 1;
+            return batch;
+        }
+
         //从内存池里取
-        char *chunk = chunk_alloc(bytes, nobjs);
+        char *chunk = 0;
+        size_t want = 0;
+        for (int attempt = 0;; ++attempt){
+            try{
+                std::lock_guard<std::mutex> guard(pool_lock);
+                if (attempt == 0){
+                    want = refill_pol->objs(bytes, cache.refill_objs[index], cache.pool_refills - cache.refill_tick[index]);
+                    if (want < 1){
+                        want = 1;
+                    }
+                    cache.refill_objs[index] = want;
+                    cache.refill_tick[index] = ++cache.pool_refills;
+                }
+                nobjs = want;
+                if (bytes <= EMaxSmallBytes::MAXSMALLBYTES){
+                    chunk = chunk_alloc(h, bytes, nobjs);
+                }
+                else{//中型区块从整页里切，页尾不够一个区块的部分交给更小的free-list
+                    size_t run_bytes = PAGE_ROUND_UP(bytes * nobjs);
+                    chunk = page_run_alloc(h, run_bytes);
+                    nobjs = run_bytes / bytes;
+                    carve_to_depot(chunk + nobjs * bytes, run_bytes - nobjs * bytes);
+                }
+                break;
+            }
+            catch (const pool_exhausted&){//已经放开pool_lock
+                handle_out_of_memory(attempt);
+            }
+        }
+        if (pressure_pending.load(std::memory_order_relaxed)){
+            relieve_pressure();
+        }
         obj **my_free_list = 0;
         obj *result = 0;
         obj *current_obj = 0, *next_obj = 0;
@@ -106,11 +1046,11 @@ namespace tt {
             return chunk;
         }
         else{
-            my_free_list = free_list + FREELIST_INDEX(bytes);
+            my_free_list = cache.free_list + index;
             result = (obj *)(chunk);
             *my_free_list = next_obj = (obj *)(chunk + bytes);
-            //将取出的多余的空间加入到相应的free list里面去
-            for (int i = 1;; ++i){
+            //将取出的多余的空间加入到线程缓存相应的free list里面去
+            for (size_t i = 1;; ++i){
                 current_obj = next_obj;
                 next_obj = (obj *)((char *)next_obj + bytes);
                 if (nobjs - 1 == i){
@@ -121,52 +1061,689 @@ namespace tt {
                     current_obj->next = next_obj;
                 }
             }
+            cache.length[index] = nobjs - 1;
             return result;
         }
     }
+    void *alloc::allocate_after_exit(size_t bytes){
+        if (bytes > EMaxBytes::MAXBYTES){
+            void *result = large_allocate(bytes, 0);
+            TINYSTL_ALLOC_STAT(stat_large_allocate(bytes));
+            return result;
+        }
+        size_t index = FREELIST_INDEX(bytes);
+        thread_cache cache;
+        void *result = refill(cache, CLASS_SIZE(index));
+        TINYSTL_ALLOC_STAT(stat_allocate(index, CLASS_SIZE(index)));
+        return result;
+    }
+    alloc::heap& alloc::home_heap(thread_cache& cache){
+        if (cache.home){
+            return *cache.home;
+        }
+        std::lock_guard<std::mutex> guard(pool_lock);
+        heap *h = heaps;
+        while (h && !h->orphan.load(std::memory_order_relaxed)){
+            h = h->next;
+        }
+        if (!h){
+            h = new heap();
+            h->start_free = h->end_free = 0;
+            h->next = heaps;
+            heaps = h;
+        }
+        //接管前孤儿heap的远程回收队列里可能还有区块，留给之后的refill取回
+        h->orphan.store(false, std::memory_order_relaxed);
+        cache.home = h;
+        return *h;
+    }
+    void alloc::release_heap(heap& h){
+        std::lock_guard<std::mutex> guard(pool_lock);
+        carve_to_depot(h.start_free, h.end_free - h.start_free);
+        h.start_free = h.end_free = 0;
+        h.orphan.store(true, std::memory_order_relaxed);
+        //先标记为孤儿再清空队列，之后别的线程回收的区块都留在它们自己那里
+        for (size_t i = 0; i < ENFreeLists::NFREELISTS; ++i){
+            obj *head = drain_remote(h, i);
+            if (head){
+                obj *tail = head;
+                while (tail->next){
+                    tail = tail->next;
+                }
+                push_to_depot(i, head, tail);
+            }
+        }
+    }
     //假设bytes已经上调为8的倍数
-    char *alloc::chunk_alloc(size_t bytes, size_t& nobjs){
+    char *alloc::chunk_alloc(heap& h, size_t bytes, size_t& nobjs){
         char *result = 0;
         size_t total_bytes = bytes * nobjs;
-        size_t bytes_left = end_free - start_free;
+        size_t align = NATURAL_ALIGN(bytes);
+        char *aligned = (char *)(((uintptr_t)h.start_free + align - 1) & ~(uintptr_t)(align - 1));
+        if (aligned <= h.end_free){//先让内存池起点满足该free-list的对齐约定
+            carve_to_depot(h.start_free, aligned - h.start_free);
+            h.start_free = aligned;
+        }
+        size_t bytes_left = h.end_free - h.start_free;
 
         if (bytes_left >= total_bytes){//内存池剩余空间完全满足需要
-            result = start_free;
-            start_free = start_free + total_bytes;
+            result = h.start_free;
+            h.start_free = h.start_free + total_bytes;
             return result;
         }
         else if (bytes_left >= bytes){//内存池剩余空间不能完全满足需要，但足够供应一个或以上的区块
             nobjs = bytes_left / bytes;
             total_bytes = nobjs * bytes;
-            result = start_free;
-            start_free += total_bytes;
+            result = h.start_free;
+            h.start_free += total_bytes;
             return result;
         }
         else{//内存池剩余空间连一个区块的大小都无法提供
-            size_t bytes_to_get = 2 * total_bytes + ROUND_UP(heap_size >> 4);
-            if (bytes_left > 0){  // 将剩余内存挂到free_list
-                obj **my_free_list = free_list + FREELIST_INDEX(bytes_left);
-                ((obj *)start_free)->next = *my_free_list;
-                *my_free_list = (obj *)start_free;
-            }
-            start_free = (char *)malloc(bytes_to_get);
-            if (!start_free){
-                obj **my_free_list = 0, *p = 0;
-                for (int i = 0; i <= EMaxBytes::MAXBYTES; i += EAlign::ALIGN){
-                    my_free_list = free_list + FREELIST_INDEX(i);
-                    p = *my_free_list;
-                    if (p != 0){
-                        *my_free_list = p->next;
-                        start_free = (char *)p;
-                        end_free = start_free + i;
-                        return chunk_alloc(bytes, nobjs);
+            grow_pool(h, total_bytes, bytes + align - EAlign::ALIGN);
+            return chunk_alloc(h, bytes, nobjs);
+        }
+    }
+    char *alloc::page_run_alloc(heap& h, size_t bytes){
+        char *aligned = (char *)(((uintptr_t)h.start_free + EPageSize::PAGE_SIZE - 1) & ~(uintptr_t)(EPageSize::PAGE_SIZE - 1));
+        if (h.start_free == 0 || aligned + bytes > h.end_free){//最坏情况下要多出将近一页用来对齐
+            size_t need = bytes + EPageSize::PAGE_SIZE - EAlign::ALIGN;
+            grow_pool(h, need, need);
+            return page_run_alloc(h, bytes);
+        }
+        carve_to_depot(h.start_free, aligned - h.start_free);  //对齐前跳过的部分
+        h.start_free = aligned + bytes;
+        return aligned;
+    }
+    void alloc::grow_pool(heap& h, size_t want, size_t need){
+        size_t bytes_left = h.end_free - h.start_free;
+        size_t bytes_to_get = CHUNK_ROUND_UP(refill_pol->grow(want, heap_size) + EChunkHeader::CHUNK_HEADER);
+        carve_to_depot(h.start_free, bytes_left);  // 将剩余内存挂到中央仓库
+        h.start_free = 0;
+        if (!charge(bytes_to_get)){//超出硬上限，退而只要刚好够用的大小
+            bytes_to_get = CHUNK_ROUND_UP(need + EChunkHeader::CHUNK_HEADER);
+            if (!charge(bytes_to_get)){
+                bytes_to_get = 0;
+            }
+        }
+        size_t charged = bytes_to_get;
+        if (charged){
+            h.start_free = (char *)chunk_src->map(bytes_to_get);
+            if (!h.start_free){
+                uncharge(charged);
+            }
+            else if (bytes_to_get > charged){//chunk_source可能多给
+                footprint_bytes.fetch_add(bytes_to_get - charged, std::memory_order_relaxed);
+            }
+        }
+        if (!h.start_free){
+            //超出预算或malloc失败，到中央仓库里找一块不小于need的区块充当内存池
+            for (size_t i = need > EMaxBytes::MAXBYTES ? size_t(ENFreeLists::NFREELISTS) : FREELIST_INDEX(need);
+                 i < ENFreeLists::NFREELISTS; ++i){
+                size_t n = 0;
+                obj *p = fetch_batch(i, n);
+                if (p != 0){
+                    if (p->next){
+                        obj *tail = p->next;
+                        while (tail->next){
+                            tail = tail->next;
+                        }
+                        push_to_depot(i, p->next, tail);
                     }
+                    h.start_free = (char *)p;
+                    h.end_free = h.start_free + CLASS_SIZE(i);
+                    return;
                 }
-                end_free = 0;
             }
-            heap_size += bytes_to_get;
-            end_free = start_free + bytes_to_get;
-            return chunk_alloc(bytes, nobjs);
+            h.end_free = 0;
+            throw pool_exhausted();
+        }
+        chunk_header *chunk = new(h.start_free) chunk_header();
+        chunk->size = bytes_to_get;
+        chunk->source = chunk_src;
+        chunk->owner = &h;
+        if (!register_chunk(chunk)){
+            chunk_src->unmap(chunk, bytes_to_get);
+            uncharge(bytes_to_get);
+            h.start_free = h.end_free = 0;
+            throw pool_exhausted();
+        }
+        TINYSTL_ALLOC_STAT(pool_grows.fetch_add(1, std::memory_order_relaxed));
+        heap_size += bytes_to_get;
+        h.end_free = h.start_free + bytes_to_get;
+        h.start_free += EChunkHeader::CHUNK_HEADER;
+    }
+    bool alloc::register_chunk(chunk_header *chunk){
+        uintptr_t first = (uintptr_t)chunk >> EChunkShift::CHUNK_SHIFT;
+        uintptr_t last = first + (chunk->size >> EChunkShift::CHUNK_SHIFT);
+        //先把要用到的叶子都准备好，失败时chunk_map保持原样
+        for (uintptr_t key = first; key != last; ++key){
+            chunk_header **&leaf = chunk_map[key >> EMapBits::MAP_BITS];
+            if (!leaf){
+                leaf = (chunk_header **)calloc((size_t)1 << EMapBits::MAP_BITS, sizeof(chunk_header *));
+                if (!leaf){
+                    return false;
+                }
+            }
+        }
+        for (uintptr_t key = first; key != last; ++key){
+            chunk_map[key >> EMapBits::MAP_BITS][key & ((1 << EMapBits::MAP_BITS) - 1)] = chunk;
+        }
+        chunk->prev = 0;
+        chunk->next = chunks;
+        if (chunks){
+            chunks->prev = chunk;
+        }
+        chunks = chunk;
+        return true;
+    }
+    void alloc::unregister_chunk(chunk_header *chunk){
+        uintptr_t first = (uintptr_t)chunk >> EChunkShift::CHUNK_SHIFT;
+        uintptr_t last = first + (chunk->size >> EChunkShift::CHUNK_SHIFT);
+        for (uintptr_t key = first; key != last; ++key){
+            chunk_map[key >> EMapBits::MAP_BITS][key & ((1 << EMapBits::MAP_BITS) - 1)] = 0;
+        }
+        if (chunk->prev){
+            chunk->prev->next = chunk->next;
+        }
+        else{
+            chunks = chunk->next;
+        }
+        if (chunk->next){
+            chunk->next->prev = chunk->prev;
+        }
+    }
+    alloc::chunk_header *alloc::chunk_of(const void *ptr){
+        uintptr_t key = (uintptr_t)ptr >> EChunkShift::CHUNK_SHIFT;
+        return chunk_map[key >> EMapBits::MAP_BITS][key & ((1 << EMapBits::MAP_BITS) - 1)];
+    }
+    void alloc::purge_pages(char *first, char *last){
+#if defined(__unix__) || defined(__APPLE__)
+        char *page_first = (char *)(((uintptr_t)first + EPageSize::PAGE_SIZE - 1) & ~(uintptr_t)(EPageSize::PAGE_SIZE - 1));
+        char *page_last = (char *)((uintptr_t)last & ~(uintptr_t)(EPageSize::PAGE_SIZE - 1));
+        if (page_first < page_last){
+            madvise(page_first, page_last - page_first, MADV_DONTNEED);
+        }
+#endif
+    }
+    void *alloc::malloc_chunk_map(size_t& bytes){
+        return aligned_alloc((size_t)1 << EChunkShift::CHUNK_SHIFT, bytes);
+    }
+    void alloc::malloc_chunk_unmap(void *p, size_t){
+        free(p);
+    }
+    void *alloc::huge_chunk_map(size_t& bytes){
+#if defined(__unix__) || defined(__APPLE__)
+        size_t huge = (size_t)1 << EHugePageShift::HUGE_PAGE_SHIFT;
+        size_t rounded = (bytes + huge - 1) & ~(huge - 1);
+        void *p;
+#ifdef MAP_HUGETLB
+        //预留了大页(vm.nr_hugepages)时直接得到按大页对齐的内存
+        p = mmap(0, rounded, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED){
+            bytes = rounded;
+            return p;
+        }
+#endif
+        //多映射一个大页，截掉首尾使起点按大页对齐，透明大页才能覆盖整个chunk
+        p = mmap(0, rounded + huge, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED){
+            return 0;
+        }
+        char *raw = (char *)p;
+        char *aligned = (char *)(((uintptr_t)raw + huge - 1) & ~(uintptr_t)(huge - 1));
+        if (aligned != raw){
+            munmap(raw, aligned - raw);
+        }
+        munmap(aligned + rounded, raw + huge - aligned);
+#ifdef MADV_HUGEPAGE
+        madvise(aligned, rounded, MADV_HUGEPAGE);  //内核不支持透明大页时失败，退回4K页
+#endif
+        bytes = rounded;
+        return aligned;
+#else
+        return malloc_chunk_map(bytes);
+#endif
+    }
+    void alloc::huge_chunk_unmap(void *p, size_t bytes){
+#if defined(__unix__) || defined(__APPLE__)
+        munmap(p, bytes);
+#else
+        malloc_chunk_unmap(p, bytes);
+#endif
+    }
+    void alloc::set_chunk_source(const chunk_source& source){
+        std::lock_guard<std::mutex> guard(pool_lock);
+        chunk_src = &source;
+    }
+    void alloc::set_memory_budget(size_t soft, size_t hard){
+        soft_budget.store(soft, std::memory_order_relaxed);
+        hard_budget.store(hard, std::memory_order_relaxed);
+        above_soft.store(false, std::memory_order_relaxed);  //按新的软上限重新判断
+    }
+    void alloc::add_pressure_handler(pressure_handler handler){
+        std::lock_guard<std::mutex> guard(handler_lock);
+        pressure_handlers().push_back(handler);
+    }
+    void alloc::remove_pressure_handler(pressure_handler handler){
+        std::lock_guard<std::mutex> guard(handler_lock);
+        std::vector<pressure_handler>& handlers = pressure_handlers();
+        for (size_t i = 0; i < handlers.size(); ++i){
+            if (handlers[i] == handler){
+                handlers.erase(handlers.begin() + i);
+                return;
+            }
+        }
+    }
+    alloc::oom_handler alloc::set_oom_handler(oom_handler handler){
+        return oom.exchange(handler);
+    }
+    size_t alloc::footprint(){
+        return footprint_bytes.load(std::memory_order_relaxed);
+    }
+    bool alloc::charge(size_t bytes){
+        size_t now = footprint_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        size_t hard = hard_budget.load(std::memory_order_relaxed);
+        if (hard && now > hard){
+            footprint_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+            return false;
+        }
+        size_t soft = soft_budget.load(std::memory_order_relaxed);
+        if (soft && now > soft && !above_soft.load(std::memory_order_relaxed)
+            && !above_soft.exchange(true, std::memory_order_relaxed)){
+            pressure_pending.store(true, std::memory_order_relaxed);
+        }
+        return true;
+    }
+    void alloc::uncharge(size_t bytes){
+        size_t now = footprint_bytes.fetch_sub(bytes, std::memory_order_relaxed) - bytes;
+        if (above_soft.load(std::memory_order_relaxed) && now <= soft_budget.load(std::memory_order_relaxed)){
+            above_soft.store(false, std::memory_order_relaxed);
+        }
+    }
+    void alloc::relieve_pressure(){
+        pressure_pending.store(false, std::memory_order_relaxed);
+        std::vector<pressure_handler> handlers;
+        {
+            std::lock_guard<std::mutex> guard(handler_lock);
+            handlers = pressure_handlers();
+        }
+        size_t soft = soft_budget.load(std::memory_order_relaxed);
+        for (pressure_handler handler : handlers){
+            handler(footprint(), soft);
+        }
+        trim();
+    }
+    void alloc::handle_out_of_memory(int attempt){
+        if (attempt == 0){
+            relieve_pressure();
+            return;
+        }
+        oom_handler handler = oom.load();
+        if (!handler){
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+    void *alloc::large_allocate(size_t bytes, size_t align){
+        for (int attempt = 0;; ++attempt){
+            if (charge(bytes)){
+                void *p = align ? aligned_alloc(align, (bytes + align - 1) & ~(align - 1)) : malloc(bytes);
+                if (p){
+                    if (pressure_pending.load(std::memory_order_relaxed)){
+                        relieve_pressure();
+                    }
+                    return p;
+                }
+                uncharge(bytes);
+            }
+            handle_out_of_memory(attempt);
+        }
+    }
+    void alloc::large_deallocate(void *ptr, size_t bytes){
+        free(ptr);
+        uncharge(bytes);
+    }
+    void alloc::set_refill_policy(const refill_policy& policy){
+        std::lock_guard<std::mutex> guard(pool_lock);
+        refill_pol = &policy;
+    }
+    size_t alloc::adaptive_objs(size_t bytes, size_t last, size_t gap){
+        size_t most = EMaxRefillBytes::MAX_REFILL_BYTES / bytes;
+        if (most > EMaxRefillObjs::MAX_REFILL_OBJS){
+            most = EMaxRefillObjs::MAX_REFILL_OBJS;
+        }
+        if (most < 2){
+            most = 2;
+        }
+        size_t n = EMinRefillObjs::MIN_REFILL_OBJS;
+        if (last != 0){
+            if (gap < EHotGap::HOT_GAP){
+                n = 2 * last;
+            }
+            else if (gap > EColdGap::COLD_GAP){
+                n = last / 2;
+            }
+            else{
+                n = last;
+            }
+        }
+        if (n < EMinRefillObjs::MIN_REFILL_OBJS){
+            n = EMinRefillObjs::MIN_REFILL_OBJS;
+        }
+        return n > most ? most : n;
+    }
+    size_t alloc::adaptive_grow(size_t want, size_t heap_size){
+        //热点free-list的批量已经按需求翻倍，不必再多要一倍
+        return want + ROUND_UP(heap_size >> 3);
+    }
+    size_t alloc::fixed_objs(size_t bytes, size_t, size_t){
+        return BATCH_OBJS(FREELIST_INDEX(bytes));
+    }
+    size_t alloc::fixed_grow(size_t want, size_t heap_size){
+        return 2 * want + ROUND_UP(heap_size >> 4);
+    }
+    size_t alloc::trim(){
+        if (!tcache_dead){
+            flush_thread_cache(tcache);
+        }
+
+        std::lock_guard<std::mutex> pool_guard(pool_lock);
+        //各heap远程回收队列里的区块都已空闲，先交给中央仓库
+        for (heap *h = heaps; h; h = h->next){
+            for (size_t i = 0; i < ENFreeLists::NFREELISTS; ++i){
+                obj *head = drain_remote(*h, i);
+                if (head){
+                    obj *tail = head;
+                    while (tail->next){
+                        tail = tail->next;
+                    }
+                    push_to_depot(i, head, tail);
+                }
+            }
+        }
+        std::unique_lock<std::mutex> depot_guards[ENFreeLists::NFREELISTS];
+        for (size_t i = 0; i < ENFreeLists::NFREELISTS; ++i){
+            depot_guards[i] = std::unique_lock<std::mutex>(depot[i].lock);
+        }
+
+        //统计每个chunk里的空闲字节数：各heap内存池剩余部分加上中央仓库里的区块
+        for (chunk_header *chunk = chunks; chunk; chunk = chunk->next){
+            chunk->free_bytes = 0;
+        }
+        for (heap *h = heaps; h; h = h->next){
+            if (h->start_free != h->end_free){
+                chunk_of(h->start_free)->free_bytes += h->end_free - h->start_free;
+            }
+        }
+        for (size_t i = 0; i < ENFreeLists::NFREELISTS; ++i){
+            central_depot& d = depot[i];
+            size_t bytes = CLASS_SIZE(i);
+            for (size_t b = 0; b < d.nbatches; ++b){
+                for (obj *p = d.batches[b]; p; p = p->next){
+                    chunk_of(p)->free_bytes += bytes;
+                }
+            }
+            for (obj *p = d.free_list; p; p = p->next){
+                chunk_of(p)->free_bytes += bytes;
+            }
+        }
+
+        //从中央仓库里摘掉落在空闲chunk里的区块，剩下的重新整理成整批
+        for (size_t i = 0; i < ENFreeLists::NFREELISTS; ++i){
+            central_depot& d = depot[i];
+            size_t bytes = CLASS_SIZE(i);
+            obj *kept = 0;
+            size_t nkept = 0;
+            for (size_t b = 0; b <= d.nbatches; ++b){
+                obj *p = b < d.nbatches ? d.batches[b] : d.free_list;
+                while (p){
+                    obj *next = p->next;
+                    if (!chunk_idle(chunk_of(p))){
+                        p->next = kept;
+                        kept = p;
+                        ++nkept;
+                        if (bytes >= 2 * EPageSize::PAGE_SIZE){//整页空闲的部分先还给操作系统，保留存放next的那一页
+                            purge_pages((char *)p + sizeof(obj), (char *)p + bytes);
+                        }
+                    }
+                    p = next;
+                }
+            }
+            size_t batch = BATCH_OBJS(i);
+            d.nbatches = 0;
+            while (nkept >= batch && d.nbatches < EDepotSlots::DEPOT_SLOTS){
+                obj *tail = kept;
+                for (size_t n = 1; n < batch; ++n){
+                    tail = tail->next;
+                }
+                d.batches[d.nbatches++] = kept;
+                kept = tail->next;
+                tail->next = 0;
+                nkept -= batch;
+            }
+            d.free_list = kept;
+        }
+
+        for (heap *h = heaps; h; h = h->next){
+            if (h->start_free != h->end_free){
+                if (chunk_idle(chunk_of(h->start_free))){
+                    h->start_free = h->end_free = 0;
+                }
+                else{
+                    purge_pages(h->start_free, h->end_free);
+                }
+            }
+        }
+
+        size_t released = 0;
+        for (chunk_header *chunk = chunks; chunk; ){
+            chunk_header *next = chunk->next;
+            if (chunk_idle(chunk)){
+                unregister_chunk(chunk);
+                heap_size -= chunk->size;
+                uncharge(chunk->size);
+                released += chunk->size;
+                chunk->source->unmap(chunk, chunk->size);
+            }
+            chunk = next;
+        }
+        return released;
+    }
+    alloc::stats_snapshot alloc::stats(){
+        stats_snapshot snapshot = stats_snapshot();
+        snapshot.nclasses = ENFreeLists::NFREELISTS;
+        for (size_t i = 0; i < ENFreeLists::NFREELISTS; ++i){
+            snapshot.classes[i].bytes = CLASS_SIZE(i);
+        }
+        {
+            std::lock_guard<std::mutex> guard(pool_lock);
+            snapshot.heap_size = heap_size;
+        }
+#ifdef TINYSTL_ALLOC_STATS
+        snapshot.enabled = true;
+        for (size_t i = 0; i < ENFreeLists::NFREELISTS; ++i){
+            stats_snapshot::size_class& c = snapshot.classes[i];
+            c.allocations = class_stats[i].allocations.load(std::memory_order_relaxed);
+            c.frees = class_stats[i].frees.load(std::memory_order_relaxed);
+            c.refills = class_stats[i].refills.load(std::memory_order_relaxed);
+            c.bytes_outstanding = class_stats[i].live.load(std::memory_order_relaxed) * c.bytes;
+            c.high_water = class_stats[i].high_water.load(std::memory_order_relaxed) * c.bytes;
+        }
+        snapshot.large_allocations = large_allocations.load(std::memory_order_relaxed);
+        snapshot.large_frees = large_frees.load(std::memory_order_relaxed);
+        snapshot.large_bytes_outstanding = large_bytes.load(std::memory_order_relaxed);
+        snapshot.pool_grows = pool_grows.load(std::memory_order_relaxed);
+        snapshot.remote_frees = remote_frees.load(std::memory_order_relaxed);
+        snapshot.bytes_outstanding = bytes_outstanding.load(std::memory_order_relaxed);
+        snapshot.high_water = high_water.load(std::memory_order_relaxed);
+#endif
+        return snapshot;
+    }
+    void alloc::dump_stats(std::ostream& out, bool json){
+        stats_snapshot s = stats();
+        if (json){
+            out << "{\"enabled\":" << (s.enabled ? "true" : "false")
+                << ",\"heap_size\":" << s.heap_size
+                << ",\"pool_grows\":" << s.pool_grows
+                << ",\"remote_frees\":" << s.remote_frees
+                << ",\"bytes_outstanding\":" << s.bytes_outstanding
+                << ",\"high_water\":" << s.high_water
+                << ",\"large\":{\"allocations\":" << s.large_allocations
+                << ",\"frees\":" << s.large_frees
+                << ",\"bytes_outstanding\":" << s.large_bytes_outstanding << "}"
+                << ",\"classes\":[";
+            for (size_t i = 0; i < s.nclasses; ++i){
+                const stats_snapshot::size_class& c = s.classes[i];
+                out << (i ? "," : "")
+                    << "{\"bytes\":" << c.bytes
+                    << ",\"allocations\":" << c.allocations
+                    << ",\"frees\":" << c.frees
+                    << ",\"refills\":" << c.refills
+                    << ",\"bytes_outstanding\":" << c.bytes_outstanding
+                    << ",\"high_water\":" << c.high_water << "}";
+            }
+            out << "]}\n";
+            return;
+        }
+        if (!s.enabled){
+            out << "tt::alloc stats disabled (define TINYSTL_ALLOC_STATS), heap_size " << s.heap_size << "\n";
+            return;
+        }
+        out << "tt::alloc heap_size " << s.heap_size << ", pool_grows " << s.pool_grows
+            << ", remote_frees " << s.remote_frees
+            << ", bytes_outstanding " << s.bytes_outstanding << ", high_water " << s.high_water << "\n";
+        out << "large: allocations " << s.large_allocations << ", frees " << s.large_frees
+            << ", bytes_outstanding " << s.large_bytes_outstanding << "\n";
+        out << "bytes\tallocations\tfrees\trefills\tbytes_outstanding\thigh_water\n";
+        for (size_t i = 0; i < s.nclasses; ++i){
+            const stats_snapshot::size_class& c = s.classes[i];
+            if (c.allocations == 0){
+                continue;
+            }
+            out << c.bytes << "\t" << c.allocations << "\t" << c.frees << "\t" << c.refills
+                << "\t" << c.bytes_outstanding << "\t" << c.high_water << "\n";
+        }
+    }
+    void alloc::set_profile_sample_rate(size_t rate){
+        if (rate){
+            profile_data& data = profile();
+            std::lock_guard<std::mutex> guard(data.lock);
+            data.rate = rate;
+        }
+        sample_rate.store(rate, std::memory_order_relaxed);
+    }
+    ptrdiff_t alloc::next_sample_interval(thread_cache& cache, size_t rate){
+        uint64_t x = cache.sample_seed;  //xorshift64
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        cache.sample_seed = x;
+        double u = (double)((x >> 11) + 1) / 9007199254740992.0;  //(0, 1]
+        double interval = -std::log(u) * (double)rate;
+        if (interval < 1){
+            return 1;
+        }
+        return interval > (double)(PTRDIFF_MAX / 2) ? PTRDIFF_MAX / 2 : (ptrdiff_t)interval;
+    }
+    void alloc::sample_allocation(thread_cache& cache, void *ptr, size_t bytes){
+        size_t rate = sample_rate.load(std::memory_order_relaxed);
+        //刚开启或改变了采样间隔时，sample_left是按旧的间隔抽取的，这一次只重新抽取、不记录
+        if (rate != 0 && rate == cache.sample_rate && ptr){
+            record_sample(ptr, bytes);
+        }
+        cache.sample_rate = rate;
+        cache.sample_left = rate ? next_sample_interval(cache, rate) : (ptrdiff_t)EProfileRecheck::PROFILE_RECHECK;
+    }
+    void alloc::record_sample(void *ptr, size_t bytes){
+        void *frames[EProfileDepth::PROFILE_DEPTH];
+        int depth = 0;
+#ifdef TINYSTL_HAVE_BACKTRACE
+        depth = backtrace(frames, EProfileDepth::PROFILE_DEPTH);
+#endif
+        chunk_header *chunk = find_chunk(ptr);
+        profile_data& data = profile();
+        std::lock_guard<std::mutex> guard(data.lock);
+        profile_bucket& bucket = data.buckets[std::vector<void *>(frames, frames + depth)];
+        ++bucket.alloc_count;
+        bucket.alloc_bytes += bytes;
+        ++bucket.inuse_count;
+        bucket.inuse_bytes += bytes;
+        live_sample& sample = data.live[ptr];
+        if (sample.bucket){//同一地址上一次的采样没有被回收掉(例如reallocate原地返回)，以这次为准
+            --sample.bucket->inuse_count;
+            sample.bucket->inuse_bytes -= sample.bytes;
+            sample.chunk ? sample.chunk->sampled.fetch_sub(1, std::memory_order_relaxed)
+                         : large_samples.fetch_sub(1, std::memory_order_relaxed);
+        }
+        sample.bucket = &bucket;
+        sample.bytes = bytes;
+        sample.chunk = chunk;
+        chunk ? chunk->sampled.fetch_add(1, std::memory_order_relaxed)
+              : large_samples.fetch_add(1, std::memory_order_relaxed);
+    }
+    void alloc::forget_sample(void *ptr){
+        profile_data& data = profile();
+        std::lock_guard<std::mutex> guard(data.lock);
+        auto it = data.live.find(ptr);
+        if (it == data.live.end()){
+            return;
+        }
+        live_sample& sample = it->second;
+        --sample.bucket->inuse_count;
+        sample.bucket->inuse_bytes -= sample.bytes;
+        sample.chunk ? sample.chunk->sampled.fetch_sub(1, std::memory_order_relaxed)
+                     : large_samples.fetch_sub(1, std::memory_order_relaxed);
+        data.live.erase(it);
+    }
+    void alloc::dump_heap_profile(std::ostream& out){
+        profile_data& data = profile();
+        std::lock_guard<std::mutex> guard(data.lock);
+        profile_bucket total = profile_bucket();
+        for (const auto& entry : data.buckets){
+            total.alloc_count += entry.second.alloc_count;
+            total.alloc_bytes += entry.second.alloc_bytes;
+            total.inuse_count += entry.second.inuse_count;
+            total.inuse_bytes += entry.second.inuse_bytes;
+        }
+        out << "heap profile: " << total.inuse_count << ": " << total.inuse_bytes
+            << " [" << total.alloc_count << ": " << total.alloc_bytes << "] @ heap_v2/" << data.rate << "\n";
+        for (const auto& entry : data.buckets){
+            const profile_bucket& b = entry.second;
+            out << b.inuse_count << ": " << b.inuse_bytes << " [" << b.alloc_count << ": " << b.alloc_bytes << "] @";
+            for (void *frame : entry.first){
+                out << " 0x" << std::hex << (uintptr_t)frame << std::dec;
+            }
+            out << "\n";
+        }
+        //pprof靠内存映射把地址对应到可执行文件和动态库
+        std::ifstream maps("/proc/self/maps");
+        if (maps){
+            out << "\nMAPPED_LIBRARIES:\n" << maps.rdbuf();
+        }
+    }
+    void alloc::start_background_trim(std::chrono::milliseconds interval){
+        stop_background_trim();
+        std::lock_guard<std::mutex> guard(trimmer.lock);
+        trimmer.stop = false;
+        trimmer.worker = std::thread([interval](){
+            std::unique_lock<std::mutex> lock(trimmer.lock);
+            while (!trimmer.cv.wait_for(lock, interval, [](){ return trimmer.stop; })){
+                lock.unlock();
+                trim();
+                lock.lock();
+            }
+        });
+    }
+    void alloc::stop_background_trim(){
+        std::thread worker;
+        {
+            std::lock_guard<std::mutex> guard(trimmer.lock);
+            trimmer.stop = true;
+            worker = std::move(trimmer.worker);
+        }
+        trimmer.cv.notify_all();
+        if (worker.joinable()){
+            worker.join();
         }
     }
 
@@ -5,16 +5,25 @@
 #ifndef TINYSTL_ALLOCATOR_H
 #define TINYSTL_ALLOCATOR_H
 
+#include <new>
+#include <utility>
+
 #include "alloc.h"
 
 
 namespace tt {
 
+    //cache line的大小，cacheline_allocator按它对齐
+    constexpr size_t CACHELINE_SIZE = 64;
+
     /*
 	**空间配置器，以变量数目为单位分配
+	**分配的内存按Align对齐，默认为alignof(T)，rebind时取Align与新类型对齐要求的较大者
 	*/
-    template<class T>
+    template<class T, size_t Align = alignof(T)>
     class allocator{
+        static_assert((Align & (Align - 1)) == 0, "Align must be a power of two");
+        static_assert(Align >= alignof(T), "Align must not be weaker than alignof(T)");
     public:
         typedef T			value_type;
         typedef T*			pointer;
@@ -24,56 +33,82 @@ namespace tt {
         typedef size_t		size_type;
         typedef ptrdiff_t	difference_type;
     public:
+        allocator() noexcept {}
+        template<class U, size_t UAlign>
+        allocator(const allocator<U, UAlign> &) noexcept {}
+
         static T *allocate();
         static T *allocate(size_t n);
         static void deallocate(T *ptr);
         static void deallocate(T *ptr, size_t n);
+        //一次分配count块、每块n个T的空间放进out[0, count)，一次回收ptrs[0, count)
+        static void allocate_batch(size_t n, size_t count, T **out);
+        static void deallocate_batch(T **ptrs, size_t count, size_t n);
 
-        static void construct(T *ptr);
-        static void construct(T *ptr, const T& value);
+        //参数原样转发给U的构造函数，原地构造
+        template<class U, class... Args>
+        static void construct(U *ptr, Args&&... args);
         static void destroy(T *ptr);
         static void destroy(T *first, T *last);
 
         template<class U>
         struct rebind{
-            using other = allocator<U>;
+            using other = allocator<U, (Align > alignof(U) ? Align : alignof(U))>;
         };
 
     };
 
+    //所有实例共用tt::alloc，总是相等
+    template<class T, size_t TAlign, class U, size_t UAlign>
+    bool operator==(const allocator<T, TAlign> &, const allocator<U, UAlign> &) { return true; }
+    template<class T, size_t TAlign, class U, size_t UAlign>
+    bool operator!=(const allocator<T, TAlign> &, const allocator<U, UAlign> &) { return false; }
+
+    //每个元素(list的节点、deque的缓冲区)都从cache line边界开始，
+    //避免SIMD加载跨行，也避免不同线程频繁写的节点共享同一行
     template<class T>
-    T *allocator<T>::allocate(){
-        return static_cast<T *>(alloc::allocate(sizeof(T)));
+    using cacheline_allocator = allocator<T, (CACHELINE_SIZE > alignof(T) ? CACHELINE_SIZE : alignof(T))>;
+
+    template<class T, size_t Align>
+    T *allocator<T, Align>::allocate(){
+        return static_cast<T *>(alloc::allocate(sizeof(T), Align));
     }
-    template<class T>
-    T *allocator<T>::allocate(size_t n){
+    template<class T, size_t Align>
+    T *allocator<T, Align>::allocate(size_t n){
         if (n == 0) return 0;
-        return static_cast<T *>(alloc::allocate(sizeof(T) * n));
+        return static_cast<T *>(alloc::allocate(sizeof(T) * n, Align));
     }
-    template<class T>
-    void allocator<T>::deallocate(T *ptr){
-        alloc::deallocate(static_cast<void *>(ptr), sizeof(T));
+    template<class T, size_t Align>
+    void allocator<T, Align>::deallocate(T *ptr){
+        alloc::deallocate(static_cast<void *>(ptr), sizeof(T), Align);
     }
-    template<class T>
-    void allocator<T>::deallocate(T *ptr, size_t n){
+    template<class T, size_t Align>
+    void allocator<T, Align>::deallocate(T *ptr, size_t n){
         if (n == 0) return;
-        alloc::deallocate(static_cast<void *>(ptr), sizeof(T)* n);
+        alloc::deallocate(static_cast<void *>(ptr), sizeof(T)* n, Align);
     }
-
-    template<class T>
-    void allocator<T>::construct(T *ptr){
-        new(ptr)T();
+    template<class T, size_t Align>
+    void allocator<T, Align>::allocate_batch(size_t n, size_t count, T **out){
+        if (n == 0 || count == 0) return;
+        alloc::allocate_batch(sizeof(T) * n, count, reinterpret_cast<void **>(out), Align);
     }
-    template<class T>
-    void allocator<T>::construct(T *ptr, const T& value){
-        new(ptr)T(value);
+    template<class T, size_t Align>
+    void allocator<T, Align>::deallocate_batch(T **ptrs, size_t count, size_t n){
+        if (n == 0 || count == 0) return;
+        alloc::deallocate_batch(reinterpret_cast<void **>(ptrs), count, sizeof(T) * n, Align);
     }
-    template<class T>
-    void allocator<T>::destroy(T *ptr){
+
+    template<class T, size_t Align>
+    template<class U, class... Args>
+    void allocator<T, Align>::construct(U *ptr, Args&&... args){
+        new(static_cast<void *>(ptr))U(std::forward<Args>(args)...);
+    }
+    template<class T, size_t Align>
+    void allocator<T, Align>::destroy(T *ptr){
         ptr->~T();
     }
-    template<class T>
-    void allocator<T>::destroy(T *first, T *last){
+    template<class T, size_t Align>
+    void allocator<T, Align>::destroy(T *first, T *last){
         for (; first != last; ++first){
             first->~T();
         }
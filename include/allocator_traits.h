@@ -0,0 +1,259 @@
+//
+// Created on 2026/10/18.
+//
+
+#ifndef TINYSTL_ALLOCATOR_TRAITS_H
+#define TINYSTL_ALLOCATOR_TRAITS_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "type_traits.h"
+
+
+namespace tt {
+
+    // 以下几个辅助模板用来检测 allocator 是否提供了某个成员，没有提供时使用默认行为
+
+    template <class Alloc, class = void>
+    struct _alloc_pocca : public false_type {};
+    template <class Alloc>
+    struct _alloc_pocca<Alloc, std::void_t<typename Alloc::propagate_on_container_copy_assignment>>
+            : public integral_constant<bool, Alloc::propagate_on_container_copy_assignment::value> {};
+
+    template <class Alloc, class = void>
+    struct _alloc_pocma : public false_type {};
+    template <class Alloc>
+    struct _alloc_pocma<Alloc, std::void_t<typename Alloc::propagate_on_container_move_assignment>>
+            : public integral_constant<bool, Alloc::propagate_on_container_move_assignment::value> {};
+
+    template <class Alloc, class = void>
+    struct _alloc_pocs : public false_type {};
+    template <class Alloc>
+    struct _alloc_pocs<Alloc, std::void_t<typename Alloc::propagate_on_container_swap>>
+            : public integral_constant<bool, Alloc::propagate_on_container_swap::value> {};
+
+    // 没有声明 is_always_equal 时，空类（无状态）的 allocator 视为总是相等
+    template <class Alloc, class = void>
+    struct _alloc_always_equal : public integral_constant<bool, std::is_empty<Alloc>::value> {};
+    template <class Alloc>
+    struct _alloc_always_equal<Alloc, std::void_t<typename Alloc::is_always_equal>>
+            : public integral_constant<bool, Alloc::is_always_equal::value> {};
+
+    template <class Alloc, class Ptr, class = void, class... Args>
+    struct _alloc_has_construct : public false_type {};
+    template <class Alloc, class Ptr, class... Args>
+    struct _alloc_has_construct<Alloc, Ptr,
+            std::void_t<decltype(std::declval<Alloc &>().construct(std::declval<Ptr>(), std::declval<Args>()...))>, Args...>
+            : public true_type {};
+
+    template <class Alloc, class Ptr, class = void>
+    struct _alloc_has_destroy : public false_type {};
+    template <class Alloc, class Ptr>
+    struct _alloc_has_destroy<Alloc, Ptr, std::void_t<decltype(std::declval<Alloc &>().destroy(std::declval<Ptr>()))>>
+            : public true_type {};
+
+    template <class Alloc, class = void>
+    struct _alloc_has_batch : public false_type {};
+    template <class Alloc>
+    struct _alloc_has_batch<Alloc, std::void_t<
+            decltype(std::declval<Alloc &>().allocate_batch(std::size_t(), std::size_t(), std::declval<typename Alloc::value_type **>())),
+            decltype(std::declval<Alloc &>().deallocate_batch(std::declval<typename Alloc::value_type **>(), std::size_t(), std::size_t()))>>
+            : public true_type {};
+
+    template <class Alloc, class = void>
+    struct _alloc_has_hint : public false_type {};
+    template <class Alloc>
+    struct _alloc_has_hint<Alloc, std::void_t<decltype(std::declval<Alloc &>().allocate(std::size_t(), std::declval<const void *>()))>>
+            : public true_type {};
+
+    template <class Alloc, class = void>
+    struct _alloc_has_batch_hint : public false_type {};
+    template <class Alloc>
+    struct _alloc_has_batch_hint<Alloc, std::void_t<decltype(std::declval<Alloc &>().allocate_batch(
+            std::size_t(), std::size_t(), std::declval<typename Alloc::value_type **>(), std::declval<const void *>()))>>
+            : public true_type {};
+
+    template <class Alloc, class = void>
+    struct _alloc_has_select : public false_type {};
+    template <class Alloc>
+    struct _alloc_has_select<Alloc, std::void_t<decltype(std::declval<const Alloc &>().select_on_container_copy_construction())>>
+            : public true_type {};
+
+
+    /**
+     * allocator_traits
+     * 容器通过它来使用 allocator，allocator 只需提供 value_type、allocate(n)、deallocate(p, n) 与 rebind，
+     * 其余成员（construct、destroy、各种 propagate_on_container_xxx）都有默认行为。
+     * 这样容器可以持有有状态的 allocator 实例（例如指向某个内存池或 arena 的指针）。
+     * @tparam Alloc 空间配置器
+     */
+    template <class Alloc>
+    struct allocator_traits {
+        using allocator_type    = Alloc;
+        using value_type        = typename Alloc::value_type;
+        using pointer           = value_type*;
+        using const_pointer     = const value_type*;
+        using size_type         = std::size_t;
+        using difference_type   = std::ptrdiff_t;
+
+        // 容器拷贝赋值、移动赋值、交换时，allocator 是否跟着内容一起转移
+        using propagate_on_container_copy_assignment = typename _alloc_pocca<Alloc>::type;
+        using propagate_on_container_move_assignment = typename _alloc_pocma<Alloc>::type;
+        using propagate_on_container_swap            = typename _alloc_pocs<Alloc>::type;
+        // 任意两个实例分配的内存是否可以互相释放
+        using is_always_equal                        = typename _alloc_always_equal<Alloc>::type;
+
+        template <class U> using rebind_alloc  = typename Alloc::template rebind<U>::other;
+        template <class U> using rebind_traits = allocator_traits<rebind_alloc<U>>;
+
+        static pointer allocate(Alloc &a, size_type n) {
+            return a.allocate(n);
+        }
+
+        // hint 是一个已分配的对象，allocator 可以把新对象放在它附近；不支持时忽略 hint
+        static pointer allocate(Alloc &a, size_type n, const void *hint) {
+            return _allocate(typename _alloc_has_hint<Alloc>::type(), a, n, hint);
+        }
+
+        static void deallocate(Alloc &a, pointer p, size_type n) {
+            a.deallocate(p, n);
+        }
+
+        // 一次分配 count 块、每块 n 个元素放进 out[0, count)；allocator 没有批量接口时逐个分配
+        static void allocate_batch(Alloc &a, size_type n, size_type count, pointer *out) {
+            _allocate_batch(typename _alloc_has_batch<Alloc>::type(), a, n, count, out);
+        }
+
+        static void allocate_batch(Alloc &a, size_type n, size_type count, pointer *out, const void *hint) {
+            _allocate_batch(typename _alloc_has_batch_hint<Alloc>::type(), a, n, count, out, hint);
+        }
+
+        static void deallocate_batch(Alloc &a, pointer *ptrs, size_type count, size_type n) {
+            _deallocate_batch(typename _alloc_has_batch<Alloc>::type(), a, ptrs, count, n);
+        }
+
+        // allocator 提供了 construct 就调用它，否则直接 placement new
+        template <class U, class... Args>
+        static void construct(Alloc &a, U *p, Args&&... args) {
+            _construct(typename _alloc_has_construct<Alloc, U*, void, Args&&...>::type(), a, p, std::forward<Args>(args)...);
+        }
+
+        template <class U>
+        static void destroy(Alloc &a, U *p) {
+            _destroy(typename _alloc_has_destroy<Alloc, U*>::type(), a, p);
+        }
+
+        // 拷贝构造容器时，新容器使用的 allocator
+        static Alloc select_on_container_copy_construction(const Alloc &a) {
+            return _select(typename _alloc_has_select<Alloc>::type(), a);
+        }
+
+    private:
+        static pointer _allocate(true_type, Alloc &a, size_type n, const void *hint) {
+            return a.allocate(n, hint);
+        }
+        static pointer _allocate(false_type, Alloc &a, size_type n, const void *) {
+            return a.allocate(n);
+        }
+
+        static void _allocate_batch(true_type, Alloc &a, size_type n, size_type count, pointer *out, const void *hint) {
+            a.allocate_batch(n, count, out, hint);
+        }
+        static void _allocate_batch(false_type, Alloc &a, size_type n, size_type count, pointer *out, const void *) {
+            allocate_batch(a, n, count, out);
+        }
+
+        static void _allocate_batch(true_type, Alloc &a, size_type n, size_type count, pointer *out) {
+            a.allocate_batch(n, count, out);
+        }
+        static void _allocate_batch(false_type, Alloc &a, size_type n, size_type count, pointer *out) {
+            size_type i = 0;
+            try {
+                for (; i < count; ++i) {
+                    out[i] = a.allocate(n);
+                }
+            } catch (...) {   // 已经分配到的还回去，整批要么全部成功，要么什么也没分配
+                for (size_type j = 0; j < i; ++j) {
+                    a.deallocate(out[j], n);
+                }
+                throw;
+            }
+        }
+
+        static void _deallocate_batch(true_type, Alloc &a, pointer *ptrs, size_type count, size_type n) {
+            a.deallocate_batch(ptrs, count, n);
+        }
+        static void _deallocate_batch(false_type, Alloc &a, pointer *ptrs, size_type count, size_type n) {
+            for (size_type i = 0; i < count; ++i) {
+                a.deallocate(ptrs[i], n);
+            }
+        }
+
+        template <class U, class... Args>
+        static void _construct(true_type, Alloc &a, U *p, Args&&... args) {
+            a.construct(p, std::forward<Args>(args)...);
+        }
+        template <class U, class... Args>
+        static void _construct(false_type, Alloc &, U *p, Args&&... args) {
+            ::new(static_cast<void *>(p)) U(std::forward<Args>(args)...);
+        }
+
+        template <class U>
+        static void _destroy(true_type, Alloc &a, U *p) {
+            a.destroy(p);
+        }
+        template <class U>
+        static void _destroy(false_type, Alloc &, U *p) {
+            p->~U();
+        }
+
+        static Alloc _select(true_type, const Alloc &a) {
+            return a.select_on_container_copy_construction();
+        }
+        static Alloc _select(false_type, const Alloc &a) {
+            return a;
+        }
+    };
+
+
+    /**
+     * allocator_holder
+     * 容器用来保存 allocator 实例的基类。
+     * 无状态的 allocator 是空类，通过空基类优化（EBO）不占用容器的空间；
+     * 有状态的（或 final 的）allocator 作为普通成员保存。
+     * @tparam Alloc 空间配置器
+     */
+    template <class Alloc, bool = std::is_empty<Alloc>::value && !std::is_final<Alloc>::value>
+    class allocator_holder : private Alloc {
+    public:
+        allocator_holder() : Alloc() {}
+        explicit allocator_holder(const Alloc &a) : Alloc(a) {}
+        explicit allocator_holder(Alloc &&a) : Alloc(std::move(a)) {}
+
+        Alloc &get_alloc() { return *this; }
+        const Alloc &get_alloc() const { return *this; }
+    };
+
+    template <class Alloc>
+    class allocator_holder<Alloc, false> {
+    public:
+        allocator_holder() : alloc_() {}
+        explicit allocator_holder(const Alloc &a) : alloc_(a) {}
+        explicit allocator_holder(Alloc &&a) : alloc_(std::move(a)) {}
+
+        Alloc &get_alloc() { return alloc_; }
+        const Alloc &get_alloc() const { return alloc_; }
+
+    private:
+        Alloc alloc_;
+    };
+
+
+}  // namespace tt
+
+
+
+#endif //TINYSTL_ALLOCATOR_TRAITS_H
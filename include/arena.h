@@ -0,0 +1,282 @@
+//
+// Created on 2026/10/18.
+//
+
+#ifndef TINYSTL_ARENA_H
+#define TINYSTL_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "alloc.h"
+
+
+namespace tt {
+
+    /*
+	**单调增长的内存区(bump pointer)
+	**分配只移动指针，deallocate什么也不做，reset()一次性收回全部内存
+	**块从tt::alloc申请，大小逐次翻倍；reset()只保留最大的一块供下次复用
+	**不是线程安全的
+	*/
+    class monotonic_arena{
+    private:
+        enum EInitialBlock{ INITIAL_BLOCK = 4096};    //第一块的大小
+        enum EMaxBlock{ MAX_BLOCK = 1024 * 1024};     //块大小翻倍的上限
+
+        //每一块开头的管理信息，块之间串成单链表，最新的在前
+        struct block{
+            block *next;
+            size_t size;  //包括block本身
+        };
+
+    public:
+        explicit monotonic_arena(size_t initial_block = EInitialBlock::INITIAL_BLOCK)
+            : blocks_(0), cur_(0), end_(0), next_size_(initial_block) {}
+        monotonic_arena(const monotonic_arena &) = delete;
+        monotonic_arena& operator=(const monotonic_arena &) = delete;
+        ~monotonic_arena() { release(); }
+
+        void *allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+        void deallocate(void *, size_t) {}
+        //收回所有分配出去的内存，保留最大的一块
+        void reset();
+        //把所有块都还给tt::alloc
+        void release();
+
+    private:
+        //当前块不够用时申请新块
+        void *allocate_slow(size_t bytes, size_t align);
+
+        block   *blocks_;     //已申请的块
+        char    *cur_;        //当前块中下一次分配的位置
+        char    *end_;        //当前块的末尾
+        size_t  next_size_;   //下一次申请新块的大小
+    };
+
+    inline void *monotonic_arena::allocate(size_t bytes, size_t align) {
+        char *p = (char *)(((uintptr_t)cur_ + align - 1) & ~(uintptr_t)(align - 1));
+        if (cur_ && p <= end_ && bytes <= size_t(end_ - p)) {
+            cur_ = p + bytes;
+            return p;
+        }
+        return allocate_slow(bytes, align);
+    }
+
+    inline void *monotonic_arena::allocate_slow(size_t bytes, size_t align) {
+        size_t size = next_size_;
+        size_t need = sizeof(block) + bytes + align;
+        while (size < need) {
+            size *= 2;
+        }
+        block *b = static_cast<block *>(alloc::allocate(size));
+        b->next = blocks_;
+        b->size = size;
+        blocks_ = b;
+        cur_ = (char *)(b + 1);
+        end_ = (char *)b + size;
+        if (next_size_ < EMaxBlock::MAX_BLOCK) {
+            next_size_ *= 2;
+        }
+        return allocate(bytes, align);
+    }
+
+    inline void monotonic_arena::reset() {
+        if (!blocks_) {
+            return;
+        }
+        //最大的一块不一定是最新的(超大的单次分配会申请一块特别大的)
+        block *largest = blocks_;
+        for (block *b = blocks_->next; b; b = b->next) {
+            if (b->size > largest->size) {
+                largest = b;
+            }
+        }
+        for (block *b = blocks_; b; ) {
+            block *next = b->next;
+            if (b != largest) {
+                alloc::deallocate(b, b->size);
+            }
+            b = next;
+        }
+        largest->next = 0;
+        blocks_ = largest;
+        cur_ = (char *)(largest + 1);
+        end_ = (char *)largest + largest->size;
+    }
+
+    inline void monotonic_arena::release() {
+        for (block *b = blocks_; b; ) {
+            block *next = b->next;
+            alloc::deallocate(b, b->size);
+            b = next;
+        }
+        blocks_ = 0;
+        cur_ = end_ = 0;
+    }
+
+
+    //arena_allocator默认使用的arena
+    struct default_arena_tag {};
+
+    //每个线程、每个Tag各有一个arena
+    template<class Tag>
+    monotonic_arena& thread_arena() {
+        thread_local monotonic_arena arena;
+        return arena;
+    }
+
+    /*
+	**从monotonic_arena中分配的空间配置器，可作为list、deque的Alloc参数
+	**实例保存所用arena的指针，默认构造时使用当前线程Tag对应的arena
+	**deallocate不做任何事，内存在arena的reset()时一次性收回，
+	**因此reset()之前必须先销毁所有使用它的容器
+	**容器赋值、交换时allocator不跟着转移，容器始终在自己的arena上分配
+	*/
+    template<class T, class Tag = default_arena_tag>
+    class arena_allocator{
+    public:
+        typedef T			value_type;
+        typedef T*			pointer;
+        typedef const T*	const_pointer;
+        typedef T&			reference;
+        typedef const T&	const_reference;
+        typedef size_t		size_type;
+        typedef ptrdiff_t	difference_type;
+    public:
+        arena_allocator() noexcept : arena_(&thread_arena<Tag>()) {}
+        explicit arena_allocator(monotonic_arena &arena) noexcept : arena_(&arena) {}
+        template<class U>
+        arena_allocator(const arena_allocator<U, Tag> &other) noexcept : arena_(other.arena()) {}
+
+        T *allocate(size_t n) {
+            if (n == 0) return 0;
+            return static_cast<T *>(arena_->allocate(sizeof(T) * n, alignof(T)));
+        }
+        void deallocate(T *, size_t) {}
+
+        monotonic_arena *arena() const { return arena_; }
+
+        //收回当前线程Tag对应arena的全部内存
+        static void reset() { thread_arena<Tag>().reset(); }
+
+        template<class U>
+        struct rebind{
+            using other = arena_allocator<U, Tag>;
+        };
+
+    private:
+        monotonic_arena *arena_;
+    };
+
+    template<class T, class U, class Tag>
+    bool operator==(const arena_allocator<T, Tag> &a, const arena_allocator<U, Tag> &b) { return a.arena() == b.arena(); }
+    template<class T, class U, class Tag>
+    bool operator!=(const arena_allocator<T, Tag> &a, const arena_allocator<U, Tag> &b) { return a.arena() != b.arena(); }
+
+
+    /*
+	**在一段外部给定的缓冲区(通常在栈上)里分配，用完后交给tt::alloc
+	**回收的正好是最后一次分配时退回指针，其余缓冲区内的回收什么也不做，缓冲区外的还给tt::alloc
+	**不是线程安全的
+	*/
+    class inline_arena_base{
+    public:
+        inline_arena_base(char *buffer, size_t size) : begin_(buffer), cur_(buffer), end_(buffer + size) {}
+        inline_arena_base(const inline_arena_base &) = delete;
+        inline_arena_base& operator=(const inline_arena_base &) = delete;
+
+        void *allocate(size_t bytes, size_t align);
+        void deallocate(void *ptr, size_t bytes, size_t align);
+        //缓冲区中已用的字节数
+        size_t used() const { return cur_ - begin_; }
+        bool owns(const void *ptr) const { return begin_ <= (const char *)ptr && (const char *)ptr < end_; }
+
+    private:
+        char    *begin_;
+        char    *cur_;
+        char    *end_;
+    };
+
+    inline void *inline_arena_base::allocate(size_t bytes, size_t align) {
+        char *p = (char *)(((uintptr_t)cur_ + align - 1) & ~(uintptr_t)(align - 1));
+        if (p <= end_ && bytes <= size_t(end_ - p)) {
+            cur_ = p + bytes;
+            return p;
+        }
+        return alloc::allocate(bytes, align);
+    }
+
+    inline void inline_arena_base::deallocate(void *ptr, size_t bytes, size_t align) {
+        if (!owns(ptr)) {
+            alloc::deallocate(ptr, bytes, align);
+        }
+        else if ((char *)ptr + bytes == cur_) {
+            cur_ = (char *)ptr;
+        }
+    }
+
+    //自带N字节缓冲区的inline_arena_base，作为局部变量时容器的内存都在栈上
+    template<size_t N>
+    class inline_arena : public inline_arena_base{
+    public:
+        inline_arena() : inline_arena_base(buffer_, N) {}
+
+    private:
+        alignas(std::max_align_t) char buffer_[N];
+    };
+
+    /*
+	**从inline_arena中分配的空间配置器，可作为list、deque的Alloc参数：
+	**  tt::inline_arena<1024> buf;
+	**  tt::list<int, tt::inline_allocator<int>> l(buf);
+	**缓冲区用完后从tt::alloc分配；arena必须比使用它的容器活得久
+	**容器赋值、交换时allocator不跟着转移，容器始终在自己的arena上分配
+	*/
+    template<class T>
+    class inline_allocator{
+    public:
+        typedef T			value_type;
+        typedef T*			pointer;
+        typedef const T*	const_pointer;
+        typedef T&			reference;
+        typedef const T&	const_reference;
+        typedef size_t		size_type;
+        typedef ptrdiff_t	difference_type;
+    public:
+        inline_allocator(inline_arena_base &arena) noexcept : arena_(&arena) {}
+        template<class U>
+        inline_allocator(const inline_allocator<U> &other) noexcept : arena_(other.arena()) {}
+
+        T *allocate(size_t n) {
+            if (n == 0) return 0;
+            return static_cast<T *>(arena_->allocate(sizeof(T) * n, alignof(T)));
+        }
+        void deallocate(T *ptr, size_t n) {
+            if (n == 0) return;
+            arena_->deallocate(ptr, sizeof(T) * n, alignof(T));
+        }
+
+        inline_arena_base *arena() const { return arena_; }
+
+        template<class U>
+        struct rebind{
+            using other = inline_allocator<U>;
+        };
+
+    private:
+        inline_arena_base *arena_;
+    };
+
+    template<class T, class U>
+    bool operator==(const inline_allocator<T> &a, const inline_allocator<U> &b) { return a.arena() == b.arena(); }
+    template<class T, class U>
+    bool operator!=(const inline_allocator<T> &a, const inline_allocator<U> &b) { return a.arena() != b.arena(); }
+
+
+}  // namespace tt
+
+
+
+#endif //TINYSTL_ARENA_H
@@ -6,22 +6,19 @@
 #define TINYSTL_CONSTRUCT_H
 
 #include <new>
+#include <utility>
 #include "type_traits.h"
 #include "iterator.h"
 
 namespace tt{
 
-    template <class T1, class T2>
-    inline void construct(T1 *ptr, const T2 &value) {
-        // TODO 学习 new 的高级用法
-        // placement new
-        // 在 ptr 指向的空间上调用 T 的构造函数
-        ::new(ptr) T1(value);
-    }
-
-    template <class T>
-    inline void construct(T *ptr) {
-        ::new(ptr) T();
+    /**
+     * 在 ptr 指向的空间上用 args 构造一个 T (placement new)
+     * 参数原样转发给 T 的构造函数，对象直接在原地构造，不经过临时对象
+     */
+    template <class T, class... Args>
+    inline void construct(T *ptr, Args&&... args) {
+        ::new(static_cast<void *>(ptr)) T(std::forward<Args>(args)...);
     }
 
     /**
@@ -30,10 +27,15 @@ namespace tt{
      * @param ptr 被析构的对象的指针
      */
     template <class T>
-    inline void destory(T *ptr) {
+    inline void destroy(T *ptr) {
         ptr->~T(); // 调用对象的析构函数
     }
 
+    template <class T>
+    inline void destory(T *ptr) {
+        destroy(ptr);
+    }
+
 
     template<class ForwardIterator>
     inline void _destroy(ForwardIterator first, ForwardIterator last, true_type){}
@@ -6,10 +6,12 @@
 #define TINYSTL_DEQUE_H
 
 #include <cstddef>
+#include <utility>
 
 #include "algorithm.h"
 #include "memory_aux.h"
 #include "allocator.h"
+#include "allocator_traits.h"
 #include "iterator.h"
 #include "type_traits.h"
 
@@ -18,11 +20,6 @@ namespace tt {
 
     template<class T, class Ref, class Ptr>
     struct deque_iterator: public iterator_base<random_access_iterator_tag, T> {
-        template< T,  Ref,  Ptr>
-        friend
-        typename deque_iterator<T, Ref, Ptr>::difference_type
-        operator-(const deque_iterator<T, Ref, Ptr> & it1, const deque_iterator<T, Ref, Ptr> & it2);
-
     public:
         using iterator_category = random_access_iterator_tag;
         using value_type        = T;
@@ -47,17 +44,20 @@ namespace tt {
                        map_pointer _node= nullptr
                        ) : cur_(_cur), first_(_first), last_(_last), node_(_node) {}
         deque_iterator(const deque_iterator<T, Ref, Ptr> &other): cur_(other.cur_), first_(other.first_), last_(other.last_), node_(other.node_) {}
+        // iterator 转换为 const_iterator
+        template<class R, class P>
+        deque_iterator(const deque_iterator<T, R, P> &other): cur_(other.cur_), first_(other.first_), last_(other.last_), node_(other.node_) {}
 
-        reference operator*() {return *cur_;}
-        pointer operator->() {return &(operator*());}
+        reference operator*() const {return *cur_;}
+        pointer operator->() const {return &(operator*());}
         self &operator++();
         self operator++(int);
         self &operator--();
         self operator--(int);
         self &operator+=(difference_type n);
         self &operator-=(difference_type n);
-        self operator+(difference_type n);
-        self operator-(difference_type n);
+        self operator+(difference_type n) const;
+        self operator-(difference_type n) const;
         bool operator==(const self & other) const;
         bool operator!=(const self & other) const;
 
@@ -86,8 +86,9 @@ namespace tt {
     //
     // 注意：迭代器失效完全看实现，不同的实现可能有不同的结果。
 
+    // deque 保存元素的 allocator，无状态时通过 EBO 不占空间；map 的 allocator 需要时由它转换得到
     template<class T, class Alloc=allocator<T>>
-    class deque {
+    class deque : private allocator_holder<Alloc> {
     public:
         using value_type            = T;               // 数据类型
         using pointer               = T*;              // 指针
@@ -101,10 +102,13 @@ namespace tt {
         using iterator              = deque_iterator<T, T&, T*>;
         using const_iterator        = deque_iterator<T, const T&, const T*>;
         using self                  = deque<T, Alloc>;
+        using allocator_type        = Alloc;
 
     private:
-        using map_allocator     = typename Alloc::template rebind<T*>::other;   // 分配中控器map_
-        using node_allocator    = Alloc;                                        // 给buffer vector分配元素
+        using data_traits       = allocator_traits<Alloc>;                              // 给buffer vector分配元素
+        using map_allocator     = typename data_traits::template rebind_alloc<T*>;      // 分配中控器map_
+        using map_traits        = allocator_traits<map_allocator>;
+        using base              = allocator_holder<Alloc>;
 
         using map_pointer       = pointer *;
 
@@ -118,14 +122,21 @@ namespace tt {
         size_type   map_size_;   // buffer vector数量
 
     public:
-        deque() { empty_initialize(); }
-        deque(const size_type& n, const value_type& x = value_type()) { fill_initialize(n, x);}
+        deque() : base() { empty_initialize(); }
+        explicit deque(const allocator_type &a) : base(a) { empty_initialize(); }
+        deque(const size_type& n, const value_type& x = value_type(), const allocator_type &a = allocator_type())
+            : base(a) { fill_initialize(n, x);}
         template<class InputIterator>
-        deque(InputIterator first, InputIterator last);
+        deque(InputIterator first, InputIterator last, const allocator_type &a = allocator_type());
         deque(const deque & other);
+        deque(deque && other) noexcept;
         deque& operator=(const deque &other);
+        deque& operator=(deque &&other) noexcept(data_traits::propagate_on_container_move_assignment::value ||
+                                                 data_traits::is_always_equal::value);
         ~deque() { delete_deque();}
 
+        allocator_type get_allocator() const { return this->get_alloc(); }
+
         bool operator==(const deque &other);
         bool operator!=(const deque &other) {return !(*this == other);}
 
@@ -142,24 +153,64 @@ namespace tt {
         reference back() { return *(finish_ - 1); }
         const_reference front() const {return *start_;}
         const_reference back() const {return *(finish_ - 1);}
-        void push_back(const value_type& x);
-        void push_front(const value_type& x);
+        void push_back(const value_type& x) { emplace_back(x); }
+        void push_back(value_type&& x) { emplace_back(std::move(x)); }
+        void push_front(const value_type& x) { emplace_front(x); }
+        void push_front(value_type&& x) { emplace_front(std::move(x)); }
+        // 用 args 原地构造元素
+        template<class... Args>
+        reference emplace_back(Args&&... args);
+        template<class... Args>
+        reference emplace_front(Args&&... args);
+        template<class... Args>
+        iterator emplace(iterator position, Args&&... args);
         void pop_back();
         void pop_front();
         iterator insert(iterator position, const value_type& x);
+        iterator insert(iterator position, value_type&& x) { return emplace(position, std::move(x)); }
         iterator  insert(iterator position,const size_type& n, const value_type& x); //返回最后一个插入的位置
         template<class InputIterator>
         iterator insert(iterator position, InputIterator first, InputIterator last);
         iterator erase(iterator position);
         iterator erase(iterator first, iterator last);
         void clear();
+        void swap(deque &other);
 
     private:
 
-        map_pointer allocate_map(size_type map_size) {return map_allocator::allocate(map_size);}
-        pointer allocate_buffer(size_type buffer_size) {return node_allocator::allocate(buffer_size);}
+        map_pointer allocate_map(size_type map_size) {
+            map_allocator a(this->get_alloc());
+            return map_traits::allocate(a, map_size);
+        }
+        void deallocate_map(map_pointer map, size_type map_size) {
+            map_allocator a(this->get_alloc());
+            map_traits::deallocate(a, map, map_size);
+        }
+        pointer allocate_buffer() {return data_traits::allocate(this->get_alloc(), buffer_size_);}
+        void deallocate_buffer(pointer buffer) {data_traits::deallocate(this->get_alloc(), buffer, buffer_size_);}
+        void destroy_range(pointer first, pointer last) {
+            for (; first != last; ++first) {
+                data_traits::destroy(this->get_alloc(), first);
+            }
+        }
+        void destroy_range(iterator first, iterator last);
         void create_map_and_nodes(size_type num = 0);
         void reallocate_map(size_type nodes_to_add, bool add_at_front);
+        // 保证 start_ 之前 / finish_ 之后还有 n 个位置，需要时分配缓冲区，返回 start_ - n / finish_ + n
+        iterator reserve_elements_at_front(size_type n);
+        iterator reserve_elements_at_back(size_type n);
+
+        // 可平凡搬移的元素在中间插入、删除时整段 memmove，不再逐个赋值
+        using relocatable       = typename is_trivially_relocatable<T>::type;
+        // 把 [first, last) 按缓冲区分段 memmove 到 result 开始处，result 在 first 之前
+        static void relocate_forward(iterator first, iterator last, iterator result);
+        // 把 [first, last) 按缓冲区分段 memmove 到 result 结束处，result 在 last 之后
+        static void relocate_backward(iterator first, iterator last, iterator result);
+        // 删除 [first, last) 并把前面 / 后面的元素移过来填补，之后 [start_, start_ + n) / [finish_ - n, finish_) 已析构
+        void close_gap_front(iterator first, iterator last, true_type);
+        void close_gap_front(iterator first, iterator last, false_type);
+        void close_gap_back(iterator first, iterator last, true_type);
+        void close_gap_back(iterator first, iterator last, false_type);
 
         void empty_initialize() { create_map_and_nodes();}        //初始化一个空 deque
         void fill_initialize(size_type n, const T &x = value_type());
@@ -172,9 +223,26 @@ namespace tt {
 
 
         void delete_deque();
+        // 接管 other 的 map 和缓冲区，other 变成没有 map 的空 deque
+        void steal(deque &other);
+        // 被移动后的 deque 没有 map，再插入元素时重新建立
+        void ensure_map() { if (!map_) create_map_and_nodes(); }
 
 
-        iterator insert_aux(iterator position, const size_type& n, const value_type& x);
+        iterator insert_aux(iterator position, const size_type& n, const value_type& x) {
+            if (!map_) {   // 空 deque 中唯一的位置就是开头
+                create_map_and_nodes();
+                position = start_;
+            }
+            return insert_aux(position, n, x, relocatable());
+        }
+        iterator insert_aux(iterator position, const size_type& n, const value_type& x, true_type);
+        iterator insert_aux(iterator position, const size_type& n, const value_type& x, false_type);
+        // 在中间原地构造一个元素
+        template<class... Args>
+        iterator emplace_aux(iterator position, true_type, Args&&... args);
+        template<class... Args>
+        iterator emplace_aux(iterator position, false_type, Args&&... args);
         template<class InputIterator>
         iterator insert_range_aux(iterator position, InputIterator first, InputIterator last, tt::true_type);
         template<class InputIterator>
@@ -199,8 +267,15 @@ namespace tt {
         // 只不过n_finish指向的buffer可能不会填满(finish_所在的buffer是n_finish)
         map_pointer n_first = map_ + (map_size_ - buffer_vector_nums) / 2;
         map_pointer n_last  = n_first + buffer_vector_nums - 1;
-        for (auto it = n_first; it <= n_last; ++it) {   // 给
-            *it = allocate_buffer(buffer_size_);
+        // 所有buffer一次批量分配，直接写进map
+        try {
+            data_traits::allocate_batch(this->get_alloc(), buffer_size_, buffer_vector_nums, n_first);
+        } catch (...) {
+            // 构造函数里抛出时不会调用~deque，map要在这里释放；被移动后重建map时也回到没有map的状态
+            deallocate_map(map_, map_size_);
+            map_      = nullptr;
+            map_size_ = 0;
+            throw;
         }
         start_.set_node(n_first);
         start_.cur_  = start_.first_;
@@ -221,29 +296,137 @@ namespace tt {
              * 预留出来给将要增加的缓冲区
              */
             map_pointer new_start = map_ + (map_size_ - new_node_num) / 2 + (add_at_front ? nodes_to_add : 0);
-            if (new_start < start_.node_) {
-                tt::copy(start_.node_, finish_.node_ + 1, new_start);
-            }else {
-                tt::copy_backward(start_.node_, finish_.node_, new_start + nodes_to_add);
-            }
+            // map 里是指针，可平凡搬移，新旧位置重叠也没关系
+            tt::uninitialized_relocate(start_.node_, finish_.node_ + 1, new_start);
 
             start_.set_node(new_start);
             finish_.set_node(new_start + old_node_num - 1);
 
         }else {
             // 现在 map 没有足够的位置，需要重新分配
-            map_size_ = 2 * new_node_num + 2;
-            map_pointer new_map = map_allocator::allocate(map_size_);
-            map_pointer new_start = new_map + (map_size_ - new_node_num) / 2 + (add_at_front ? nodes_to_add : 0);
-            tt::copy(start_.node_, finish_.node_, new_start);
-            map_allocator::deallocate(map_, map_size_);
+            size_type new_map_size = 2 * new_node_num + 2;
+            map_pointer new_map = allocate_map(new_map_size);
+            map_pointer new_start = new_map + (new_map_size - new_node_num) / 2 + (add_at_front ? nodes_to_add : 0);
+            tt::uninitialized_relocate(start_.node_, finish_.node_ + 1, new_start);
+            deallocate_map(map_, map_size_);   // 按旧的大小归还
 
             map_ = new_map;
+            map_size_ = new_map_size;
             start_.set_node(new_start);
             finish_.set_node(new_start + old_node_num - 1);
         }
     }
 
+    template<class T, class Alloc>
+    typename deque<T, Alloc>::iterator
+    deque<T, Alloc>::reserve_elements_at_front(size_type n) {
+        size_type vacancies = start_.cur_ - start_.first_;
+        if (n > vacancies) {
+            size_type new_nodes = (n - vacancies + buffer_size_ - 1) / buffer_size_;
+            if (new_nodes > size_type(start_.node_ - map_)) {
+                reallocate_map(new_nodes, true);
+            }
+            size_type i = 1;
+            try {
+                for (; i <= new_nodes; ++i) {
+                    *(start_.node_ - i) = allocate_buffer();
+                }
+            } catch (...) {
+                for (size_type j = 1; j < i; ++j) {
+                    deallocate_buffer(*(start_.node_ - j));
+                }
+                throw;
+            }
+        }
+        return start_ - difference_type(n);
+    }
+
+    template<class T, class Alloc>
+    typename deque<T, Alloc>::iterator
+    deque<T, Alloc>::reserve_elements_at_back(size_type n) {
+        // 同 push_back：finish_ 不会停在缓冲区的末尾
+        size_type vacancies = finish_.last_ - finish_.cur_ - 1;
+        if (n > vacancies) {
+            size_type new_nodes = (n - vacancies + buffer_size_ - 1) / buffer_size_;
+            if (new_nodes > map_size_ - size_type(finish_.node_ - map_) - 1) {
+                reallocate_map(new_nodes, false);
+            }
+            size_type i = 1;
+            try {
+                for (; i <= new_nodes; ++i) {
+                    *(finish_.node_ + i) = allocate_buffer();
+                }
+            } catch (...) {
+                for (size_type j = 1; j < i; ++j) {
+                    deallocate_buffer(*(finish_.node_ + j));
+                }
+                throw;
+            }
+        }
+        return finish_ + difference_type(n);
+    }
+
+    template<class T, class Alloc>
+    void
+    deque<T, Alloc>::relocate_forward(iterator first, iterator last, iterator result) {
+        difference_type n = last - first;
+        while (n > 0) {
+            // 每一段都不跨越源和目标的缓冲区
+            difference_type len = tt::min(n, tt::min(difference_type(first.last_ - first.cur_),
+                                                     difference_type(result.last_ - result.cur_)));
+            tt::relocate_n(first.cur_, len, result.cur_);
+            first += len;
+            result += len;
+            n -= len;
+        }
+    }
+
+    template<class T, class Alloc>
+    void
+    deque<T, Alloc>::relocate_backward(iterator first, iterator last, iterator result) {
+        difference_type n = last - first;
+        while (n > 0) {
+            // 正好在缓冲区开头时，前面一段在上一个缓冲区的末尾
+            pointer src = last.cur_ == last.first_ ? *(last.node_ - 1) + buffer_size_ : last.cur_;
+            pointer dst = result.cur_ == result.first_ ? *(result.node_ - 1) + buffer_size_ : result.cur_;
+            difference_type src_len = last.cur_ == last.first_ ? difference_type(buffer_size_) : last.cur_ - last.first_;
+            difference_type dst_len = result.cur_ == result.first_ ? difference_type(buffer_size_) : result.cur_ - result.first_;
+            difference_type len = tt::min(n, tt::min(src_len, dst_len));
+            tt::relocate_n(src - len, len, dst - len);
+            last -= len;
+            result -= len;
+            n -= len;
+        }
+    }
+
+    template<class T, class Alloc>
+    void
+    deque<T, Alloc>::close_gap_front(iterator first, iterator last, true_type) {
+        destroy_range(first, last);
+        relocate_backward(start_, first, last);
+    }
+
+    template<class T, class Alloc>
+    void
+    deque<T, Alloc>::close_gap_front(iterator first, iterator last, false_type) {
+        tt::move_backward(start_, first, last);
+        destroy_range(start_, start_ + (last - first));
+    }
+
+    template<class T, class Alloc>
+    void
+    deque<T, Alloc>::close_gap_back(iterator first, iterator last, true_type) {
+        destroy_range(first, last);
+        relocate_forward(last, finish_, first);
+    }
+
+    template<class T, class Alloc>
+    void
+    deque<T, Alloc>::close_gap_back(iterator first, iterator last, false_type) {
+        tt::move(last, finish_, first);
+        destroy_range(finish_ - (last - first), finish_);
+    }
+
 
 
     template<class T, class Alloc>
@@ -253,10 +436,9 @@ namespace tt {
         create_map_and_nodes(n);
 
         // 填充数据
-        for (auto it = start_.node_; it < finish_.node_; ++it) {   // 先填满[ start_.node_, finish_.node_ )
-            uninitialized_fill_n(*it, buffer_size_, x);
+        for (auto it = start_; it != finish_; ++it) {
+            data_traits::construct(this->get_alloc(), it.cur_, x);
         }
-        uninitialized_fill(finish_.first_, finish_.cur_, x);   // 在填充最后一个buffer
     }
 
 
@@ -273,12 +455,12 @@ namespace tt {
     template<class InputIterator>
     void
     deque<T, Alloc>::copy_initialize(InputIterator first, InputIterator last, false_type) {
-        difference_type n = distance(first, last);
+        difference_type n = tt::distance(first, last);
         // 开辟内存
         create_map_and_nodes(n);
         // input_iterator_tag 类型迭代器只能逐个遍历
-        for (auto it = start_; it != finish_; ++it) {
-            construct(start_.cur_, *first);
+        for (auto it = start_; it != finish_; ++it, ++first) {
+            data_traits::construct(this->get_alloc(), it.cur_, *first);
         }
 
         // 不能使用以下实现，因为会将first视为POD true类型，调用memcpy的时候会出错(无法发生迭代器类型向void*的类型转换)
@@ -296,16 +478,28 @@ namespace tt {
     template<class T, class Alloc>
     void
     deque<T, Alloc>::delete_deque() {
-        for (auto it = start_.node_; it < finish_.node_; ++it) {  // 析构[start_.node_, finish_.node_)
-            node_allocator::destroy(*it, *it + buffer_size_);
-            node_allocator::deallocate(*it, buffer_size_);
+        if (!map_) {   // 已经被移动走了
+            return;
         }
-        // 析构 finish_.node_
-        node_allocator::destroy(finish_.first_, finish_.cur_);     // 只调用有元素部分的析构函数
-        node_allocator::deallocate(finish_.first_, buffer_size_);  // 但是回收时要回收全部
+        destroy_range(start_, finish_);     // 只调用有元素部分的析构函数
+        // 但是回收时要回收全部buffer，它们在map里是连续的，一次批量回收
+        data_traits::deallocate_batch(this->get_alloc(), start_.node_, finish_.node_ - start_.node_ + 1, buffer_size_);
+        deallocate_map(map_, map_size_);   // map_里面的元素是指针，属于POD，不用析构
+    }
 
-        map_allocator::destroy(map_, map_ + map_size_);   // 这行可以不写，以为map_里面的元素时指针，属于POD，就算是调用了也啥也不做
-        map_allocator::deallocate(map_, map_size_);
+
+    template<class T, class Alloc>
+    void
+    deque<T, Alloc>::destroy_range(iterator first, iterator last) {
+        if (first.node_ == last.node_) {
+            destroy_range(first.cur_, last.cur_);
+            return;
+        }
+        destroy_range(first.cur_, first.last_);
+        for (map_pointer node = first.node_ + 1; node < last.node_; ++node) {
+            destroy_range(*node, *node + buffer_size_);
+        }
+        destroy_range(last.first_, last.cur_);
     }
 
 
@@ -314,23 +508,74 @@ namespace tt {
 
     template<class T, class Alloc>
     typename deque<T, Alloc>::iterator
-    deque<T, Alloc>::insert_aux(deque::iterator position, const deque::size_type &n, const value_type &x) {
+    deque<T, Alloc>::insert_aux(deque::iterator position, const deque::size_type &n, const value_type &x, true_type) {
+        value_type copy = x;   // x 可能就是容器里的元素，搬动后会失效
+        difference_type elems_before = position - start_;
+        if (size_type(elems_before) < (size() >> 1)) {  // 前面元素少：前面的整段前移 n 个位置
+            iterator new_start = reserve_elements_at_front(n);
+            position = start_ + elems_before;   // map 可能重新分配，position 已经失效
+            relocate_forward(start_, position, new_start);
+            iterator gap = new_start + elems_before;
+            iterator cur = gap;
+            try {
+                for (; cur != position; ++cur) {
+                    data_traits::construct(this->get_alloc(), cur.cur_, copy);
+                }
+            } catch (...) {
+                // 恢复原样，归还新分配的缓冲区
+                destroy_range(gap, cur);
+                relocate_backward(new_start, gap, position);
+                for (map_pointer node = new_start.node_; node < start_.node_; ++node) {
+                    deallocate_buffer(*node);
+                }
+                throw;
+            }
+            start_ = new_start;
+        }else {   // 后面的整段后移 n 个位置
+            iterator new_finish = reserve_elements_at_back(n);
+            position = start_ + elems_before;
+            iterator gap_end = position + difference_type(n);
+            relocate_backward(position, finish_, new_finish);
+            iterator cur = position;
+            try {
+                for (; cur != gap_end; ++cur) {
+                    data_traits::construct(this->get_alloc(), cur.cur_, copy);
+                }
+            } catch (...) {
+                destroy_range(position, cur);
+                relocate_forward(gap_end, new_finish, position);
+                for (map_pointer node = finish_.node_ + 1; node <= new_finish.node_; ++node) {
+                    deallocate_buffer(*node);
+                }
+                throw;
+            }
+            finish_ = new_finish;
+        }
+        return start_ + elems_before + n - 1;
+    }
+
+    template<class T, class Alloc>
+    typename deque<T, Alloc>::iterator
+    deque<T, Alloc>::insert_aux(deque::iterator position, const deque::size_type &n, const value_type &x, false_type) {
+        value_type copy = x;   // x 可能就是容器里的元素，后移时会被覆盖
         auto elems_before = position - start_;
-        if (elems_before < (size() >> 1)) {  // 前面元素少：移动前面
-            for (int i = n; n > 0; --i) {
-                push_front(x);
+        if (size_type(elems_before) < (size() >> 1)) {  // 前面元素少：移动前面
+            for (size_type i = n; i > 0; --i) {
+                push_front(copy);
             }
-            tt::copy(start_ + n, start_ + n + elems_before, start_);
-            for (auto it = start_ + elems_before; it != position; ++it) {
-                *it = x;
+            // push_front 可能重新分配 map，position 已经失效，用下标重新定位
+            tt::move(start_ + n, start_ + n + elems_before, start_);
+            for (auto it = start_ + elems_before; it != start_ + elems_before + n; ++it) {
+                *it = copy;
             }
         }else {
-            for (int i = n; n > 0; --i) {
-                push_back(x);
+            for (size_type i = n; i > 0; --i) {
+                push_back(copy);
             }
-            tt::copy_backward(position, finish_ - n, finish_);
+            position = start_ + elems_before;
+            tt::move_backward(position, finish_ - n, finish_);
             for (auto it = position; it != position + n; ++it) {
-                *it = x;
+                *it = copy;
             }
         }
         return start_ + elems_before + n - 1;
@@ -353,32 +598,93 @@ namespace tt {
                                       InputIterator first,
                                       InputIterator last,
                                       tt::false_type) {
-        for (; first != last; ++first) {
-            insert_aux(position, 1, *first);
+        difference_type index = position - start_;
+        for (; first != last; ++first, ++index) {
+            insert_aux(start_ + index, 1, *first);
         }
-        return position - 1;
+        return start_ + (index - 1);
     }
 
     template<class T, class Alloc>
     template<class InputIterator>
-    deque<T, Alloc>::deque(InputIterator first, InputIterator last) {
+    deque<T, Alloc>::deque(InputIterator first, InputIterator last, const allocator_type &a) : base(a) {
         copy_initialize(first, last, typename tt::is_integral<InputIterator>::type());
     }
 
     template<class T, class Alloc>
-    deque<T, Alloc>::deque(const deque &other) {
+    deque<T, Alloc>::deque(const deque &other)
+        : base(data_traits::select_on_container_copy_construction(other.get_alloc())) {
         copy_initialize(other.start_, other.finish_, typename tt::is_integral<const_iterator>::type());
     }
 
+    template<class T, class Alloc>
+    deque<T, Alloc>::deque(deque &&other) noexcept : base(std::move(other.get_alloc())) {
+        steal(other);
+    }
+
+    template<class T, class Alloc>
+    void
+    deque<T, Alloc>::steal(deque &other) {
+        start_    = other.start_;
+        finish_   = other.finish_;
+        map_      = other.map_;
+        map_size_ = other.map_size_;
+        other.start_ = other.finish_ = iterator();
+        other.map_      = nullptr;
+        other.map_size_ = 0;
+    }
+
+    template<class T, class Alloc>
+    deque<T, Alloc> &
+    deque<T, Alloc>::operator=(deque &&other)
+            noexcept(data_traits::propagate_on_container_move_assignment::value || data_traits::is_always_equal::value) {
+        if (this != &other) {
+            if (data_traits::propagate_on_container_move_assignment::value || this->get_alloc() == other.get_alloc()) {
+                // 先用原来的 allocator 释放全部内存，再接管 other 的
+                delete_deque();
+                if (data_traits::propagate_on_container_move_assignment::value) {
+                    this->get_alloc() = std::move(other.get_alloc());
+                }
+                steal(other);
+            }else {
+                // other 的内存不能由自己的 allocator 释放，只能逐个移动元素
+                clear();
+                for (iterator it = other.start_; it != other.finish_; ++it) {
+                    emplace_back(std::move(*it));
+                }
+                other.clear();
+            }
+        }
+        return *this;
+    }
+
     template<class T, class Alloc>
     deque<T, Alloc> &
     deque<T, Alloc>::operator=(const deque &other) {
-        if (*this != other) {
+        if (this != &other) {
+            // 先用原来的 allocator 释放全部内存，再决定是否换用 other 的 allocator
+            delete_deque();
+            if (data_traits::propagate_on_container_copy_assignment::value) {
+                this->get_alloc() = other.get_alloc();
+            }
             copy_initialize(other.start_, other.finish_, typename tt::is_integral<const_iterator>::type());
         }
         return *this;
     }
 
+    template<class T, class Alloc>
+    void
+    deque<T, Alloc>::swap(deque &other) {
+        // 两个 allocator 不相等且不随交换转移时，交换的结果是未定义的（同标准库）
+        if (data_traits::propagate_on_container_swap::value) {
+            tt::swap(this->get_alloc(), other.get_alloc());
+        }
+        tt::swap(start_, other.start_);
+        tt::swap(finish_, other.finish_);
+        tt::swap(map_, other.map_);
+        tt::swap(map_size_, other.map_size_);
+    }
+
 
 
     template<class T, class Alloc>
@@ -391,50 +697,128 @@ namespace tt {
     }
 
     template<class T, class Alloc>
-    void
-    deque<T, Alloc>::push_back(const value_type &x) {
+    template<class... Args>
+    typename deque<T, Alloc>::reference
+    deque<T, Alloc>::emplace_back(Args&&... args) {
+        ensure_map();
         if (finish_.cur_ != finish_.last_ - 1) {   // 备用空间 大于等于2个
-            construct(finish_.cur_, x);
+            data_traits::construct(this->get_alloc(), finish_.cur_, std::forward<Args>(args)...);
             ++finish_.cur_;
         }else {
              // 需要看看map的备用空间够不够
              if (size_type(finish_.node_ - map_ + 1) >= map_size_) {  // 备用空间不够：重新分配内存
                  reallocate_map(1, false);
              }
-             *(finish_.node_ + 1) = node_allocator::allocate(buffer_size_);
-             construct(finish_.cur_, x);
+             *(finish_.node_ + 1) = allocate_buffer();
+             try {
+                 data_traits::construct(this->get_alloc(), finish_.cur_, std::forward<Args>(args)...);
+             } catch (...) {
+                 deallocate_buffer(*(finish_.node_ + 1));
+                 throw;
+             }
              ++finish_;
         }
+        return back();
     }
 
     template<class T, class Alloc>
-    void
-    deque<T, Alloc>::push_front(const value_type &x) {
+    template<class... Args>
+    typename deque<T, Alloc>::reference
+    deque<T, Alloc>::emplace_front(Args&&... args) {
+        ensure_map();
         if (start_.cur_ != start_.first_) {  // 看看是否在最前面
-            construct(--start_.cur_, x);
+            data_traits::construct(this->get_alloc(), start_.cur_ - 1, std::forward<Args>(args)...);
+            --start_.cur_;
         }else {
             // 在最前面
             // 看看前面还有没有剩余buffer vector
             if (map_ - start_.node_ == 0) {  // 没有：重新分配
                 reallocate_map(1, true);
             }
-            *(start_.node_ - 1) = node_allocator::allocate(buffer_size_);
+            *(start_.node_ - 1) = allocate_buffer();
+            try {
+                data_traits::construct(this->get_alloc(), *(start_.node_ - 1) + (buffer_size_ - 1), std::forward<Args>(args)...);
+            } catch (...) {
+                deallocate_buffer(*(start_.node_ - 1));
+                throw;
+            }
             --start_;
-            construct(start_.cur_, x);
+        }
+        return front();
+    }
+
+    template<class T, class Alloc>
+    template<class... Args>
+    typename deque<T, Alloc>::iterator
+    deque<T, Alloc>::emplace(iterator position, Args&&... args) {
+        if (position == finish_) {
+            emplace_back(std::forward<Args>(args)...);
+            return finish_ - 1;
+        }else if (position == start_) {
+            emplace_front(std::forward<Args>(args)...);
+            return start_;
+        }else {
+            return emplace_aux(position, relocatable(), std::forward<Args>(args)...);
         }
     }
 
+    template<class T, class Alloc>
+    template<class... Args>
+    typename deque<T, Alloc>::iterator
+    deque<T, Alloc>::emplace_aux(iterator position, true_type, Args&&... args) {
+        // args 可能引用容器里的元素，先在一旁构造好，搬动完其他元素后再把它的字节搬进空位
+        alignas(T) unsigned char buf[sizeof(T)];
+        pointer tmp = reinterpret_cast<pointer>(buf);
+        data_traits::construct(this->get_alloc(), tmp, std::forward<Args>(args)...);
+        difference_type index = position - start_;
+        try {
+            if (size_type(index) < (size() >> 1)) {
+                iterator new_start = reserve_elements_at_front(1);
+                relocate_forward(start_, start_ + index, new_start);
+                start_ = new_start;
+            }else {
+                iterator new_finish = reserve_elements_at_back(1);
+                relocate_backward(start_ + index, finish_, new_finish);
+                finish_ = new_finish;
+            }
+        } catch (...) {   // 只有分配缓冲区会失败，这时还没有搬动元素
+            data_traits::destroy(this->get_alloc(), tmp);
+            throw;
+        }
+        iterator result = start_ + index;
+        tt::relocate_n(tmp, 1, result.cur_);
+        return result;
+    }
+
+    template<class T, class Alloc>
+    template<class... Args>
+    typename deque<T, Alloc>::iterator
+    deque<T, Alloc>::emplace_aux(iterator position, false_type, Args&&... args) {
+        // 中间的元素要逐个移动，新元素先构造成临时对象(args 可能引用容器里的元素)
+        value_type tmp(std::forward<Args>(args)...);
+        difference_type index = position - start_;
+        if (size_type(index) < (size() >> 1)) {   // 前面的元素前移一个位置
+            emplace_front(std::move(front()));
+            tt::move(start_ + 2, start_ + index + 1, start_ + 1);
+        }else {   // 后面的元素后移一个位置
+            emplace_back(std::move(back()));
+            tt::move_backward(start_ + index, finish_ - 2, finish_ - 1);
+        }
+        *(start_ + index) = std::move(tmp);
+        return start_ + index;
+    }
+
     template<class T, class Alloc>
     void
     deque<T, Alloc>::pop_back() {
         if (finish_.cur_ == finish_.first_) {  // 尾迭代器正好指向当前buffer最前面：需要更新 finish_ 的信息
-            node_allocator::deallocate(finish_.first_, buffer_size_);
+            deallocate_buffer(finish_.first_);
             finish_.set_node(finish_.node_ - 1);
             finish_.cur_ = finish_.last_ - 1;
-            node_allocator::deallocate(finish_.cur_);
+            data_traits::destroy(this->get_alloc(), finish_.cur_);
         }else {
             // 尾元素不在缓冲区头部：直接析构
-            node_allocator::destroy(--finish_.cur_);
+            data_traits::destroy(this->get_alloc(), --finish_.cur_);
         }
     }
 
@@ -442,12 +826,12 @@ namespace tt {
     void
     deque<T, Alloc>::pop_front() {
         if (start_.cur_ == start_.last_ - 1) {  // 在尾部
-            node_allocator::destroy(start_.cur_);
-            node_allocator::deallocate(start_.first_, buffer_size_);
+            data_traits::destroy(this->get_alloc(), start_.cur_);
+            deallocate_buffer(start_.first_);
             start_.set_node(start_.node_ + 1);
             start_.cur_  = start_.first_;
         }else {
-            node_allocator::destroy(start_.cur_);
+            data_traits::destroy(this->get_alloc(), start_.cur_);
             ++start_.cur_;
         }
     }
@@ -495,21 +879,36 @@ namespace tt {
     typename deque<T, Alloc>::iterator
     deque<T, Alloc>::erase(deque::iterator position) {
         auto next = position + 1;
-        difference_type num = position - start_ + 1;  // 计算删除点之前的元素
-        if (size_type(num) < (size() >> 1)) {   // 之前的元素比较少：就移动之前的
-            tt::copy_backward(start_, position, next);
-            pop_front();
+        difference_type index = position - start_;  // 计算删除点之前的元素
+        if (size_type(index) < (size() >> 1)) {   // 之前的元素比较少：就移动之前的
+            close_gap_front(position, next, relocatable());
+            if (start_.cur_ == start_.last_ - 1) {   // 原来的头元素是所在缓冲区的最后一个
+                deallocate_buffer(start_.first_);
+                start_.set_node(start_.node_ + 1);
+                start_.cur_ = start_.first_;
+            }else {
+                ++start_.cur_;
+            }
         }else {
-            tt::copy(next, finish_, position);
-            pop_back();
+            close_gap_back(position, next, relocatable());
+            if (finish_.cur_ == finish_.first_) {
+                deallocate_buffer(finish_.first_);
+                finish_.set_node(finish_.node_ - 1);
+                finish_.cur_ = finish_.last_ - 1;
+            }else {
+                --finish_.cur_;
+            }
         }
-        return start_ + num;
+        return start_ + index;
     }
 
     template<class T, class Alloc>
     typename deque<T, Alloc>::iterator
     deque<T, Alloc>::erase(deque::iterator first, deque::iterator last) {
-        if (start_ == finish_ && finish_ == last) {
+        if (first == last) {   // 空区间，否则后面的元素会移动赋值给自己
+            return first;
+        }
+        if (first == start_ && last == finish_) {
             clear();
             return finish_;
         }
@@ -517,20 +916,18 @@ namespace tt {
         difference_type elems_before = first   - start_;   // 删除区间前方元素个数
         difference_type elems_after  = finish_ - last;
         if (elems_before < elems_after) {  // 前面元素比较少
-            tt::copy_backward(start_, first, last);
+            close_gap_front(first, last, relocatable());   // 之后前面的 n 个已经析构
             iterator new_start = start_ + n;
-            node_allocator::destroy(start_, new_start);  // 析构前面的
-            // 释放掉无用的map
+            // 释放掉无用的buffer
             for (map_pointer node = start_.node_; node < new_start.node_; ++node) {
-                node_allocator::deallocate(node, buffer_size_);
+                deallocate_buffer(*node);
             }
             start_ = new_start;
         } else {   // 后面元素比较少
-            tt::copy(last, finish_, finish_);
+            close_gap_back(first, last, relocatable());
             iterator new_finish = finish_ - n;
-            node_allocator::destroy(new_finish, finish_);
-            for(map_pointer node = new_finish.node_; node <= finish_.node_; ++node) {
-                node_allocator::deallocate(node, buffer_size_);
+            for(map_pointer node = new_finish.node_ + 1; node <= finish_.node_; ++node) {
+                deallocate_buffer(*node);
             }
             finish_ = new_finish;
         }
@@ -543,16 +940,18 @@ namespace tt {
         // 恢复空构造时的初始
         // 针对头尾以外的buffer
         for (map_pointer node = start_.node_ + 1; node < finish_.node_; ++node) {
-            node_allocator::destroy(*node, *node + buffer_size_);
-            node_allocator::deallocate(*node, buffer_size_);
+            destroy_range(*node, *node + buffer_size_);
+        }
+        if (finish_.node_ - start_.node_ > 1) {
+            data_traits::deallocate_batch(this->get_alloc(), start_.node_ + 1, finish_.node_ - start_.node_ - 1, buffer_size_);
         }
         if (start_.node_ == finish_.node_) {  // 只剩余1个缓冲区
-            node_allocator::destroy(start_.cur_, finish_.cur_);
+            destroy_range(start_.cur_, finish_.cur_);
             finish_ = start_;
         }else {  // 剩余2个缓冲区
-            node_allocator::destroy(start_.first_, start_.last_);
-            node_allocator::destroy(finish_.first_, finish_.last_);
-            node_allocator::deallcate(finish_.first_, buffer_size_);  // 释放尾buffer，保留头buffer
+            destroy_range(start_.cur_, start_.last_);
+            destroy_range(finish_.first_, finish_.cur_);
+            deallocate_buffer(finish_.first_);  // 释放尾buffer，保留头buffer
             finish_ = start_;
         }
     }
@@ -578,6 +977,9 @@ namespace tt {
     template<class T, class Ref, class Ptr>
     typename deque_iterator<T, Ref, Ptr>::difference_type
     operator-(const deque_iterator<T, Ref, Ptr> & last, const deque_iterator<T, Ref, Ptr> & first) {
+        if (last.node_ == first.node_) {   // 同一个缓冲区(包括被移动后没有 map 的空 deque)
+            return last.cur_ - first.cur_;
+        }
         return (last.node_ - first.node_ - 1) * deque_iterator<T, Ref, Ptr>::buffer_size_ +
                 (last.cur_ - last.first_) + (first.last_ - first.cur_);
     }
@@ -633,12 +1035,13 @@ namespace tt {
     template<class T, class Ref, class Ptr>
     typename deque_iterator<T, Ref, Ptr>::self &
     deque_iterator<T, Ref, Ptr>::operator+=(deque_iterator::difference_type n) {  // n可能是负数
-        difference_type offset = cur_ + n - first_;
-        if (offset >= 0 && offset < buffer_size_) {  // 不超出当前缓冲区
+        difference_type offset = n + (cur_ - first_);
+        if (offset >= 0 && offset < difference_type(buffer_size_)) {  // 不超出当前缓冲区
             cur_ += n;
         }else {
             // 计算向左还是向右超出了多少个缓冲区。
-            difference_type node_offset = offset > n ? offset / buffer_size_ : -(offset - 1) / buffer_size_ + 1;
+            difference_type node_offset = offset > 0 ? offset / difference_type(buffer_size_)
+                                                     : -difference_type((-offset - 1) / buffer_size_) - 1;
             set_node(node_ + node_offset);
             cur_ = first_ + (offset - node_offset * buffer_size_);
         }
@@ -653,7 +1056,7 @@ namespace tt {
 
     template<class T, class Ref, class Ptr>
     typename deque_iterator<T, Ref, Ptr>::self
-    deque_iterator<T, Ref, Ptr>::operator+(deque_iterator::difference_type n) {
+    deque_iterator<T, Ref, Ptr>::operator+(deque_iterator::difference_type n) const {
         auto tmp = *this;
         tmp += n;
         return tmp;
@@ -661,7 +1064,7 @@ namespace tt {
 
     template<class T, class Ref, class Ptr>
     typename deque_iterator<T, Ref, Ptr>::self
-    deque_iterator<T, Ref, Ptr>::operator-(deque_iterator::difference_type n) {
+    deque_iterator<T, Ref, Ptr>::operator-(deque_iterator::difference_type n) const {
         auto tmp = *this;
         tmp += -n;
         return tmp;
@@ -7,10 +7,16 @@
 
 #include <cstddef>
 #include <initializer_list>
+#include <iterator>
 #include <limits>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 #include "iterator.h"
 #include "allocator.h"
+#include "allocator_traits.h"
+#include "slab.h"
 #include "construct.h"
 #include "type_traits.h"
 #include "algorithm.h"
@@ -18,13 +24,19 @@
 
 namespace tt {
 
+    //节点的链接部分，头节点只有这一部分，直接放在list对象里
+    struct list_node_base {
+        list_node_base* prev;
+        list_node_base* next;
+    };
+
     template<class T>
-    struct list_node {
-        list_node<T>* prev;
-        list_node<T>* next;
+    struct list_node : public list_node_base {
         T data;
-        list_node() : prev(nullptr), next(nullptr), data(T()) {}
-        list_node(list_node<T>* p, list_node<T>* n, const T& d) : prev(p), next(n), data(d) {}
+        list_node() : list_node_base{nullptr, nullptr}, data() {}
+        //其余参数原样转发给T的构造函数，data直接在节点里构造
+        template<class... Args>
+        list_node(list_node_base* p, list_node_base* n, Args&&... args) : list_node_base{p, n}, data(std::forward<Args>(args)...) {}
     };
 
     template<class T, class Ref, class Ptr>
@@ -35,28 +47,31 @@ namespace tt {
         typedef ptrdiff_t                   difference_type;
         typedef size_t                      size_type;
         typedef bidirectional_iterator_tag  iterator_category;
+        typedef list_node_base*             base_ptr;
         typedef list_node<T>*               node_ptr;
 
-        node_ptr node;
+        base_ptr node;  //指向头节点时是end()，其余都是list_node<T>
 
         list_iterator() {}
-        list_iterator(const node_ptr n) : node(n) {}
+        list_iterator(const base_ptr n) : node(n) {}
         list_iterator(const list_iterator & other) : node(other.node) {}
         bool operator==(const list_iterator & other) const { return node == other.node; }
         bool operator!=(const list_iterator & other) const { return node != other.node; }
-        reference operator*() const { return node->data; }
+        reference operator*() const { return static_cast<node_ptr>(node)->data; }
         pointer operator->() const { return &(operator*()); }
         list_iterator& operator++() { node = node->next; return *this; }
-        list_iterator operator++(int) { node_ptr tmp = node; ++*this; return tmp; }
+        list_iterator operator++(int) { base_ptr tmp = node; ++*this; return tmp; }
         list_iterator& operator--() { node = node->prev; return *this; }
-        list_iterator operator--(int) { node_ptr tmp = node; --*this; return tmp; }
+        list_iterator operator--(int) { base_ptr tmp = node; --*this; return tmp; }
     };
 
 
 
 
+    //list保存的是节点的allocator，无状态时通过EBO不占空间
+    //新节点以前一个节点为hint分配；换成slab_allocator(tt::list<T, tt::slab_allocator<T>>)时同一条链的节点尽量挨在一起
     template<class T, class Alloc = allocator<T>>
-    class list {
+    class list : private allocator_holder<typename allocator_traits<Alloc>::template rebind_alloc<list_node<T>>> {
     public:
         typedef T                       value_type;
         typedef size_t                  size_type;
@@ -66,33 +81,57 @@ namespace tt {
         typedef const T*                const_pointer;
 
         typedef list_node<T>*                           link_type;
+        typedef list_node_base*                         base_ptr;
         typedef list_iterator<T, T&, T*>                iterator;
         typedef list_iterator<T, const T&, const T*>    const_iterator;
         typedef list<T, Alloc>                          self;
+        typedef Alloc                                   allocator_type;
 
     private:
-        typedef typename Alloc::template rebind<list_node<T>>::other     list_allocator;
+        typedef typename allocator_traits<Alloc>::template rebind_alloc<list_node<T>>     list_allocator;
+        typedef allocator_traits<list_allocator>                                          node_traits;
+        typedef allocator_holder<list_allocator>                                          base;
 
-        link_type head;
+        enum ENodeBatch{ NODE_BATCH = 64};  //批量分配、回收节点时每批的个数
+
+        //头节点放在list对象里，不需要分配，移动list时把链表接到新的头节点上
+        list_node_base head;
     public:
         //构造，拷贝，赋值，析构
-        list() { empty_init(); }
-        list(size_type n, const value_type& x = value_type());
+        list() : base() { empty_init(); }
+        explicit list(const allocator_type& a) : base(list_allocator(a)) { empty_init(); }
+        list(size_type n, const value_type& x = value_type(), const allocator_type& a = allocator_type());
         template<class InputIterator>
-        list(InputIterator first, InputIterator last);
+        list(InputIterator first, InputIterator last, const allocator_type& a = allocator_type());
         list(const list & other);
+        list(list && other) noexcept;
         list& operator=(const list & other);
+        list& operator=(list && other) noexcept(node_traits::propagate_on_container_move_assignment::value ||
+                                                node_traits::is_always_equal::value);
         ~list();
 
-        iterator begin() { return head->next; }  //node->next是list_node<T>*,可以用改返回值初始化iterator
-        iterator end() { return head; }
-        const_iterator begin() const { return head->next; } //const this 使用
-        const_iterator end() const { return head; }
-        bool  empty() { return head->next == head; }
+        allocator_type get_allocator() const { return allocator_type(this->get_alloc()); }
+
+        iterator begin() { return head.next; }  //node->next是list_node_base*,可以用该返回值初始化iterator
+        iterator end() { return &head; }
+        const_iterator begin() const { return head.next; } //const this 使用
+        const_iterator end() const { return const_cast<base_ptr>(&head); }
+        bool  empty() { return head.next == &head; }
         size_type size();
 
         void push_back(const value_type& x);
+        void push_back(value_type&& x) { emplace_back(std::move(x)); }
         void push_front(const value_type& x);
+        void push_front(value_type&& x) { emplace_front(std::move(x)); }
+        iterator insert(iterator position, const value_type& x) { return emplace(position, x); }
+        iterator insert(iterator position, value_type&& x) { return emplace(position, std::move(x)); }
+        //用args在新节点里原地构造元素
+        template<class... Args>
+        iterator emplace(iterator position, Args&&... args);
+        template<class... Args>
+        reference emplace_back(Args&&... args) { return *emplace(end(), std::forward<Args>(args)...); }
+        template<class... Args>
+        reference emplace_front(Args&&... args) { return *emplace(begin(), std::forward<Args>(args)...); }
         iterator insert(iterator position, const size_type& n, const value_type& x);
         template<class InputIterator>
         iterator insert(iterator position, InputIterator first, InputIterator last);
@@ -111,19 +150,38 @@ namespace tt {
         void swap(list & other);
         void sort();
 
-        bool operator==(const list &other) const { return head == other.head; }
-        bool operator!=(const list &other) const { return head != other.head; }
+        bool operator==(const list &other) const { return &head == &other.head; }
+        bool operator!=(const list &other) const { return &head != &other.head; }
 
     private:
-        //分配空间并初始化
-        link_type create_node(const value_type& x);
+        //分配空间并用args初始化，hint传给allocator
+        template<class... Args>
+        link_type create_node(const void *hint, Args&&... args);
         void destroy_node(link_type p);
+        //只释放节点的空间，不析构
+        void put_node(link_type p) { node_traits::deallocate(this->get_alloc(), p, 1); }
+        //在position之前分配新节点时给allocator的hint：前一个节点，它是头节点时用position本身，都是头节点(空list)时不给
+        const void *node_hint(iterator position) const {
+            base_ptr p = position.node->prev != &head ? position.node->prev : position.node;
+            return p != &head ? static_cast<const void *>(static_cast<link_type>(p)) : 0;
+        }
+        //把节点p接到position之前
+        void link_node(iterator position, base_ptr p);
+        //析构并回收[first, last)之间的节点(已经从链表上摘下)，攒满一批一起回收
+        void destroy_nodes(base_ptr first, base_ptr last);
         void empty_init();
+        //把from的所有节点接到空的头节点to上，from变为空
+        static void move_nodes(list_node_base &to, list_node_base &from);
         iterator insert_aux(iterator position, const size_type& n, const value_type& x);
         template<class InputIterator>
         iterator insert_range_aux(iterator position, InputIterator first, InputIterator last, tt::true_type);
         template<class InputIterator>
         iterator insert_range_aux(iterator position, InputIterator first, InputIterator last, tt::false_type);
+        //最后一个参数表示迭代器能否多次遍历(前向迭代器)，tt和std的迭代器都可以
+        template<class InputIterator>
+        void insert_range(iterator position, InputIterator first, InputIterator last, tt::false_type);
+        template<class ForwardIterator>
+        void insert_range(iterator position, ForwardIterator first, ForwardIterator last, tt::true_type);
         void transfer(iterator position, iterator first, iterator last);
         void delete_list();
 
@@ -131,31 +189,62 @@ namespace tt {
 
     //构造，拷贝，赋值，析构
     template<class T, class Alloc>
-    list<T, Alloc>::list(size_type n, const value_type& x) {
+    list<T, Alloc>::list(size_type n, const value_type& x, const allocator_type& a) : base(list_allocator(a)) {
         empty_init();
         insert(end(), n, x);
     }
     template<class T, class Alloc>
     template<class InputIterator>
-    list<T, Alloc>::list(InputIterator first, InputIterator last) {
+    list<T, Alloc>::list(InputIterator first, InputIterator last, const allocator_type& a) : base(list_allocator(a)) {
         empty_init();
         insert(end(), first, last);
 
     }
     template<class T, class Alloc>
-    list<T, Alloc>::list(const list & other) { //必须要定begin()和end()的const版本，传入const list使用const this调用成员函数,无法找到合适的const begin().
+    list<T, Alloc>::list(const list & other)
+        : base(node_traits::select_on_container_copy_construction(other.get_alloc())) { //必须要定begin()和end()的const版本，传入const list使用const this调用成员函数,无法找到合适的const begin().
         empty_init();
         insert(end(), other.begin(), other.end());
     }
     template<class T, class Alloc>
+    list<T, Alloc>::list(list && other) noexcept : base(std::move(other.get_alloc())) {
+        empty_init();
+        move_nodes(head, other.head);
+    }
+    template<class T, class Alloc>
     list<T, Alloc>& list<T, Alloc>::operator=(const list & other) {
         if (*this != other) {
-            clear();
+            clear();  //节点都已还给原来的allocator，头节点不需要分配
+            if (node_traits::propagate_on_container_copy_assignment::value) {
+                this->get_alloc() = other.get_alloc();
+            }
             insert(end(), other.begin(), other.end());
         }
         return *this;
     }
     template<class T, class Alloc>
+    list<T, Alloc>& list<T, Alloc>::operator=(list && other)
+            noexcept(node_traits::propagate_on_container_move_assignment::value || node_traits::is_always_equal::value) {
+        if (*this != other) {
+            clear();
+            if (node_traits::propagate_on_container_move_assignment::value) {
+                this->get_alloc() = std::move(other.get_alloc());
+                move_nodes(head, other.head);
+            }
+            else if (this->get_alloc() == other.get_alloc()) {
+                move_nodes(head, other.head);
+            }
+            else {
+                //other的节点不能由自己的allocator回收，只能逐个移动元素
+                for (iterator it = other.begin(); it != other.end(); ++it) {
+                    emplace_back(std::move(*it));
+                }
+                other.clear();
+            }
+        }
+        return *this;
+    }
+    template<class T, class Alloc>
     list<T, Alloc>::~list() {
         delete_list();
     }
@@ -164,7 +253,7 @@ namespace tt {
     template<class T, class Alloc>
     typename list<T, Alloc>::size_type
     list<T, Alloc>::size() {
-        return (size_type)distance(begin(), end());
+        return (size_type)tt::distance(begin(), end());
     }
 
     //    template<class T, class Alloc>
@@ -193,6 +282,14 @@ namespace tt {
         insert_aux(begin(), 1, x);
     }
     template<class T, class Alloc>
+    template<class... Args>
+    typename list<T, Alloc>::iterator
+    list<T, Alloc>::emplace(iterator position, Args&&... args) {
+        link_type p = create_node(node_hint(position), std::forward<Args>(args)...);
+        link_node(position, p);
+        return p;
+    }
+    template<class T, class Alloc>
     typename list<T, Alloc>::iterator
     list<T, Alloc>::insert(iterator position, const size_type& n, const value_type& x) {
         return insert_aux(position, n, x);
@@ -207,20 +304,22 @@ namespace tt {
     template<class T, class Alloc>
     typename list<T, Alloc>::iterator
     list<T, Alloc>::erase(iterator iter) {
-        link_type next_node = iter.node->next;
+        base_ptr next_node = iter.node->next;
         iter.node->prev->next = iter.node->next;
         iter.node->next->prev = iter.node->prev;
-        destroy_node(iter.node);
+        destroy_node(static_cast<link_type>(iter.node));
         return iterator(next_node);
     }
 
     template<class T, class Alloc>
     typename list<T, Alloc>::iterator
     list<T, Alloc>::erase(list::iterator first, list::iterator last) {
-        while (first != last) {
-            first = erase(first);
+        if (first != last) {
+            first.node->prev->next = last.node;
+            last.node->prev = first.node->prev;
+            destroy_nodes(first.node, last.node);
         }
-        return first;
+        return last;
     }
 
     template<class T, class Alloc>
@@ -281,13 +380,13 @@ namespace tt {
     }
     template<class T, class Alloc>
     void list<T, Alloc>::reverse() {
+        if (head.next == &head || head.next->next == &head) return;
         auto first = begin();
-        auto curr = first;
-        ++curr;
-        auto last = end();
-        if (first == last || ++curr = last) return;
-        while (begin() != last) {
-            transfer(begin(), curr, ++curr);
+        ++first;
+        while (first != end()) {
+            auto old = first;
+            ++first;
+            transfer(begin(), old, first);
         }
     }
     template<class T, class Alloc>
@@ -311,57 +410,136 @@ namespace tt {
     }
     template<class T, class Alloc>
     void list<T, Alloc>::swap(list & other) {
-        tt::swap(head, other.node);
+        //两个allocator不相等且不随交换转移时，交换的结果是未定义的(同标准库)
+        if (node_traits::propagate_on_container_swap::value) {
+            tt::swap(this->get_alloc(), other.get_alloc());
+        }
+        list_node_base tmp;
+        move_nodes(tmp, head);
+        move_nodes(head, other.head);
+        move_nodes(other.head, tmp);
     }
     template<class T, class Alloc>
     void list<T, Alloc>::sort() {
-        if (head->next == head || head->next->next == head) return;
-        list carry;
-        list counter[64];
-        int fill = 0;
-        while (!empty()) {
-            carry.splice(carry.begin(), *this, begin());
-            int i = 0;
-            while (i < fill && !counter[i].empty()) {
-                counter[i].merge(carry);
-                carry.swap(counter[i++]);
+        if (head.next == &head || head.next->next == &head) return;
+        //临时list都用*this的allocator构造：allocator可能没有默认构造函数，
+        //比较抛出异常时临时list析构，手上的节点也要交还给分配它们的allocator
+        list carry(get_allocator());
+        alignas(list) unsigned char buf[64 * sizeof(list)];
+        list *counter = reinterpret_cast<list *>(buf);
+        int fill = 0;   //counter[0, fill)已构造
+        try {
+            while (!empty()) {
+                carry.splice(carry.begin(), *this, begin());
+                int i = 0;
+                while (i < fill && !counter[i].empty()) {
+                    counter[i].merge(carry);
+                    carry.swap(counter[i++]);
+                }
+                if (i == fill) {
+                    new (counter + fill) list(get_allocator());
+                    ++fill;
+                }
+                carry.swap(counter[i]);
             }
-            carry.swap(counter[i]);
-            if (i == fill) ++fill;
+            for (int i = 1; i < fill; ++i)
+                counter[i].merge(counter[i - 1]);
+        }
+        catch (...) {
+            for (int i = 0; i < fill; ++i)
+                counter[i].~list();
+            throw;
         }
-        for (int i = 1; i < fill; ++i)
-            counter[i].merge(counter[i - 1]);
-        swap(counter[fill - 1]);
+        //只搬动节点
+        splice(end(), counter[fill - 1]);
+        for (int i = 0; i < fill; ++i)
+            counter[i].~list();
     }
     //private函数
     template<class T, class Alloc>
+    template<class... Args>
     typename list<T, Alloc>::link_type
-    list<T, Alloc>::create_node(const value_type& x) {
-        link_type position = list_allocator::allocate();
-        list_allocator::construct(position, list_node<T>(nullptr, nullptr, x));
+    list<T, Alloc>::create_node(const void *hint, Args&&... args) {
+        link_type position = node_traits::allocate(this->get_alloc(), 1, hint);
+        try {
+            node_traits::construct(this->get_alloc(), position, nullptr, nullptr, std::forward<Args>(args)...);
+        }
+        catch (...) {
+            put_node(position);
+            throw;
+        }
         return position;
     }
     template<class T, class Alloc>
     void list<T, Alloc>::destroy_node(list::link_type p) {
-        list_allocator::destroy(p);
-        list_allocator::deallocate(p);
+        node_traits::destroy(this->get_alloc(), p);
+        put_node(p);
+    }
+    template<class T, class Alloc>
+    void list<T, Alloc>::link_node(iterator position, base_ptr p) {
+        p->next = position.node;
+        p->prev = position.node->prev;
+        position.node->prev->next = p;
+        position.node->prev = p;
+    }
+    template<class T, class Alloc>
+    void list<T, Alloc>::destroy_nodes(base_ptr first, base_ptr last) {
+        link_type nodes[ENodeBatch::NODE_BATCH];
+        size_type count = 0;
+        while (first != last) {
+            base_ptr next = first->next;
+            link_type node = static_cast<link_type>(first);
+            node_traits::destroy(this->get_alloc(), node);
+            nodes[count++] = node;
+            if (count == ENodeBatch::NODE_BATCH) {
+                node_traits::deallocate_batch(this->get_alloc(), nodes, count, 1);
+                count = 0;
+            }
+            first = next;
+        }
+        if (count > 0) {
+            node_traits::deallocate_batch(this->get_alloc(), nodes, count, 1);
+        }
     }
     template<class T, class Alloc>
     void list<T, Alloc>::empty_init() {
-        head = list_allocator::allocate();
-        head->next = head;
-        head->prev = head;
+        head.next = &head;
+        head.prev = &head;
+    }
+    template<class T, class Alloc>
+    void list<T, Alloc>::move_nodes(list_node_base &to, list_node_base &from) {
+        if (from.next == &from) {
+            to.next = to.prev = &to;
+            return;
+        }
+        to.next = from.next;
+        to.prev = from.prev;
+        to.next->prev = &to;
+        to.prev->next = &to;
+        from.next = from.prev = &from;
     }
     template<class T, class Alloc>
     typename list<T, Alloc>::iterator
     list<T, Alloc>::insert_aux(iterator position, const size_type& n, const value_type& x) {
-        auto i = n;
-        for (; i > 0; --i) {
-            auto new_node = create_node(x);   //iterator是调用node的接口，一般在参数以及返回当中
-            new_node->next = position.node;
-            new_node->prev = position.node->prev;
-            position.node->prev->next = new_node;
-            position.node->prev = new_node;
+        if (n == 0) {
+            return position;
+        }
+        //节点按批分配，每批只调用一次allocator；以position前一个节点为hint，新节点尽量紧跟在它后面
+        link_type nodes[ENodeBatch::NODE_BATCH];
+        for (size_type left = n; left > 0; ) {
+            size_type count = left < ENodeBatch::NODE_BATCH ? left : size_type(ENodeBatch::NODE_BATCH);
+            node_traits::allocate_batch(this->get_alloc(), 1, count, nodes, node_hint(position));
+            for (size_type i = 0; i < count; ++i) {
+                try {
+                    node_traits::construct(this->get_alloc(), nodes[i], nullptr, nullptr, x);
+                }
+                catch (...) {
+                    node_traits::deallocate_batch(this->get_alloc(), nodes + i, count - i, 1);
+                    throw;
+                }
+                link_node(position, nodes[i]);   //iterator是调用node的接口，一般在参数以及返回当中
+            }
+            left -= count;
         }
         return position.node->prev;
     }
@@ -376,13 +554,47 @@ namespace tt {
     typename list<T, Alloc>::iterator
     list<T, Alloc>::insert_range_aux(iterator position, InputIterator first, InputIterator last, tt::false_type) {
         if (first == last) {
-            std::cout << "error" << std::endl;
             return position;
         }
+        typedef typename iterator_traits<InputIterator>::iterator_category category;
+        insert_range(position, first, last,
+                     typename tt::integral_constant<bool, std::is_convertible<category, forward_iterator_tag>::value ||
+                                                          std::is_convertible<category, std::forward_iterator_tag>::value>::type());
+        return position.node->prev;
+    }
+    template<class T, class Alloc>
+    template<class InputIterator>
+    void
+    list<T, Alloc>::insert_range(iterator position, InputIterator first, InputIterator last, tt::false_type) {
+        //只能遍历一次，不知道有多少个元素，逐个分配
         for (; first != last; ++first) {
-            insert_aux(position, 1, *first);
+            link_node(position, create_node(node_hint(position), *first));
+        }
+    }
+    template<class T, class Alloc>
+    template<class ForwardIterator>
+    void
+    list<T, Alloc>::insert_range(iterator position, ForwardIterator first, ForwardIterator last, tt::true_type) {
+        size_type n = 0;  //std的迭代器标签和tt的不同，不能用tt::distance
+        for (ForwardIterator it = first; it != last; ++it) {
+            ++n;
+        }
+        link_type nodes[ENodeBatch::NODE_BATCH];
+        for (size_type left = n; left > 0; ) {
+            size_type count = left < ENodeBatch::NODE_BATCH ? left : size_type(ENodeBatch::NODE_BATCH);
+            node_traits::allocate_batch(this->get_alloc(), 1, count, nodes, node_hint(position));
+            for (size_type i = 0; i < count; ++i, ++first) {
+                try {
+                    node_traits::construct(this->get_alloc(), nodes[i], nullptr, nullptr, *first);
+                }
+                catch (...) {
+                    node_traits::deallocate_batch(this->get_alloc(), nodes + i, count - i, 1);
+                    throw;
+                }
+                link_node(position, nodes[i]);
+            }
+            left -= count;
         }
-        return position.node->prev;
     }
     template<class T, class Alloc>
     void  list<T, Alloc>::transfer(iterator position, iterator first, iterator last) {
@@ -390,7 +602,7 @@ namespace tt {
             position.node->prev->next = first.node;
             last.node->prev->next = position.node;
             first.node->prev->next = last.node;
-            link_type tmp = first.node->prev;
+            base_ptr tmp = first.node->prev;
             first.node->prev = position.node->prev;
             position.node->prev = last.node->prev;
             last.node->prev = tmp;
@@ -401,7 +613,6 @@ namespace tt {
     void
     list<T, Alloc>::delete_list() {
         erase(begin(), end());
-        destroy_node(head);
     }
 
 
@@ -5,8 +5,13 @@
 #ifndef TINYSTL_MEMORY_AUX_H
 #define TINYSTL_MEMORY_AUX_H
 
+#include <cstddef>
 #include <cstring>
+#include <atomic>
+#include <new>
+#include <type_traits>
 #include <utility>
+#include "alloc.h"
 #include "type_traits.h"
 #include "construct.h"
 #include "algorithm.h"
@@ -31,15 +36,26 @@ namespace tt {
     template<class InputIterator, class ForwardIterator>
     ForwardIterator _uninitialized_copy_aux(InputIterator first, InputIterator last,
                                             ForwardIterator result, true_type){
-        memcpy(result, first, (last - first) * sizeof(*first));
+        if (first != last){//空区间的指针可能是空指针，不能交给memcpy
+            memcpy(result, first, (last - first) * sizeof(*first));
+        }
         return result + (last - first);
     }
     template<class InputIterator, class ForwardIterator>
     ForwardIterator _uninitialized_copy_aux(InputIterator first, InputIterator last,
                                             ForwardIterator result, false_type){
+        typedef typename iterator_traits<ForwardIterator>::value_type value_type;
         int i = 0;
-        for (; first != last; ++first, ++i){
-            construct((result + i), *first);
+        try {
+            for (; first != last; ++first, ++i){
+                construct((result + i), *first);
+            }
+        }
+        catch (...) {//已经构造的要析构掉，要么全部构造，要么一个也不构造
+            for (; i > 0; --i){
+                (&*(result + i - 1))->~value_type();
+            }
+            throw;
         }
         return (result + i);
     }
@@ -92,55 +108,521 @@ namespace tt {
     ForwardIterator _uninitialized_fill_n_aux(ForwardIterator first,
                                               Size n, const T& x, false_type){
         int i = 0;
-        for (; i != n; ++i){
-            construct((T*)(first + i), x);
+        try {
+            for (; i != n; ++i){
+                construct((T*)(first + i), x);
+            }
+        }
+        catch (...) {
+            for (; i > 0; --i){
+                ((T*)(first + i - 1))->~T();
+            }
+            throw;
         }
         return (first + i);
     }
 
+    /***************************************************************************/
+    /*
+    **可平凡搬移(trivially relocatable)：把对象的字节原样复制到新位置、原处不再析构，
+    **效果等同于在新位置移动构造再析构原对象。
+    **平凡拷贝且平凡析构的类型天然满足；自己管理堆内存但不保存自身地址的类型(SharedPtr、小字符串等)
+    **也满足，用TINYSTL_TRIVIALLY_RELOCATABLE(类型)声明后，容器搬动它们的元素时直接memmove
+    */
+    template<class T>
+    struct is_trivially_relocatable
+        : integral_constant<bool, std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value> {};
+
+    //在全局命名空间、类型定义之后使用；类模板需要自己写偏特化
+#define TINYSTL_TRIVIALLY_RELOCATABLE(...) \
+    namespace tt { template<> struct is_trivially_relocatable<__VA_ARGS__> : tt::true_type {}; }
+
+    template<class T>
+    T *_uninitialized_relocate_aux(T *first, T *last, T *result, true_type);
+    template<class T>
+    T *_uninitialized_relocate_aux(T *first, T *last, T *result, false_type);
+
+    /*
+    **把[first, last)的对象搬到未初始化的result处，返回result的末尾；之后[first, last)成为未初始化的内存
+    **可平凡搬移的类型直接memmove，两段可以重叠；
+    **其他类型逐个移动构造后再析构原对象，两段不能重叠，移动构造抛出异常时已构造的被析构、原对象保持不变
+    */
+    template<class T>
+    inline T *uninitialized_relocate(T *first, T *last, T *result){
+        return _uninitialized_relocate_aux(first, last, result, typename is_trivially_relocatable<T>::type());
+    }
+    template<class T, class Size>
+    inline T *relocate_n(T *first, Size n, T *result){
+        return uninitialized_relocate(first, first + n, result);
+    }
+    template<class T>
+    T *_uninitialized_relocate_aux(T *first, T *last, T *result, true_type){
+        if (first != last){//空区间的指针可能是空指针，不能交给memmove
+            memmove(static_cast<void *>(result), static_cast<const void *>(first), (last - first) * sizeof(T));
+        }
+        return result + (last - first);
+    }
+    template<class T>
+    T *_uninitialized_relocate_aux(T *first, T *last, T *result, false_type){
+        T *cur = result;
+        try {
+            for (T *p = first; p != last; ++p, ++cur){
+                ::new(static_cast<void *>(cur)) T(std::move(*p));
+            }
+        }
+        catch (...) {
+            for (; cur != result; ){
+                (--cur)->~T();
+            }
+            throw;
+        }
+        for (; first != last; ++first){
+            first->~T();
+        }
+        return cur;
+    }
 
 
-    template <class T>
-    class SharedPtr {
-    public:
-        explicit SharedPtr(T *ptr) : ptr_(ptr), cnt_(new unsigned int(1)) {}
-        SharedPtr(const SharedPtr<T> &other) : ptr_(other.ptr_), cnt_(other.cnt_) { ++(*cnt_); }
-        SharedPtr<T>& operator=(const SharedPtr &other) {
-            if (this != other) {
-                --(*cnt_);
-                if (*cnt_ == 0) {
-                    delete ptr_;
-                    delete cnt_;
+
+    /***************************************************************************/
+    /*
+    **引用计数的两种策略，作为SharedPtr、WeakPtr的CountPolicy参数
+    **atomic_count：原子计数，可以在线程间共享；增加计数用relaxed，减少计数用acq_rel，
+    **减到0的一方能看到其他线程之前对对象的所有修改后再析构
+    **nonatomic_count：普通整数，只在单个线程内使用时省掉原子指令
+    */
+    struct atomic_count{
+        typedef std::atomic<long> type;
+
+        static long load(const type& c) { return c.load(std::memory_order_relaxed); }
+        static void increment(type& c) { c.fetch_add(1, std::memory_order_relaxed); }
+        //减1，减到0时返回true
+        static bool decrement(type& c){
+            return c.fetch_sub(1, std::memory_order_acq_rel) == 1;
+        }
+        //不为0时加1并返回true，WeakPtr::lock()用
+        static bool increment_if_nonzero(type& c){
+            long n = c.load(std::memory_order_relaxed);
+            while (n != 0){
+                if (c.compare_exchange_weak(n, n + 1, std::memory_order_relaxed)){
+                    return true;
                 }
-                ptr_ = other.ptr_;
-                cnt_ = other.cnt_;
-                ++cnt_;
             }
-            return *this;
+            return false;
         }
+    };
 
-        ~SharedPtr() {
-            --(*cnt_);
-            if (*cnt_ == 0) {
-                delete cnt_;
-                delete ptr_;
+    struct nonatomic_count{
+        typedef long type;
+
+        static long load(const type& c) { return c; }
+        static void increment(type& c) { ++c; }
+        static bool decrement(type& c) { return --c == 0; }
+        static bool increment_if_nonzero(type& c){
+            if (c == 0){
+                return false;
+            }
+            ++c;
+            return true;
+        }
+    };
+
+    /*
+    **SharedPtr的控制块
+    **strong为SharedPtr的个数；weak为WeakPtr的个数，strong不为0时再加1，
+    **这样最后一个SharedPtr析构对象后只需再减一次weak就能决定是否回收控制块
+    **对象怎样析构、控制块怎样回收由创建它的一方填入的两个函数决定，不需要虚函数
+    */
+    template<class CountPolicy>
+    struct sp_control_block{
+        typedef typename CountPolicy::type count_type;
+
+        count_type  strong;
+        count_type  weak;
+        void (*dispose)(sp_control_block *);  //strong减到0时析构对象
+        void (*destroy)(sp_control_block *);  //weak减到0时回收控制块
+
+        sp_control_block(void (*d)(sp_control_block *), void (*r)(sp_control_block *))
+            : strong(1), weak(1), dispose(d), destroy(r) {}
+
+        void add_ref() { CountPolicy::increment(strong); }
+        void add_weak() { CountPolicy::increment(weak); }
+        bool add_ref_lock() { return CountPolicy::increment_if_nonzero(strong); }
+        void release(){
+            if (CountPolicy::decrement(strong)){
+                dispose(this);
+                release_weak();
+            }
+        }
+        void release_weak(){
+            if (CountPolicy::decrement(weak)){
+                destroy(this);
             }
         }
+        long use_count() const { return CountPolicy::load(strong); }
+    };
+
+    //SharedPtr(T*)使用：对象在别处分配，控制块只保存指针，用delete析构
+    template<class T, class CountPolicy>
+    struct sp_pointer_block : sp_control_block<CountPolicy>{
+        typedef sp_control_block<CountPolicy> base;
+
+        T *ptr;
 
+        explicit sp_pointer_block(T *p) : base(&dispose_ptr, &destroy_block), ptr(p) {}
 
-        T& operator*() {
-            return *ptr_;
+        static void dispose_ptr(base *b) { delete static_cast<sp_pointer_block *>(b)->ptr; }
+        static void destroy_block(base *b){
+            sp_pointer_block *self = static_cast<sp_pointer_block *>(b);
+            self->~sp_pointer_block();
+            alloc::deallocate(self, sizeof(sp_pointer_block), alignof(sp_pointer_block));
         }
+    };
+
+    //make_shared使用：对象紧跟在计数后面，与控制块在同一次分配里，通常也在同一条缓存行上
+    template<class T, class CountPolicy>
+    struct sp_inplace_block : sp_control_block<CountPolicy>{
+        typedef sp_control_block<CountPolicy> base;
 
-        T* operator->() {
-            return &(*this);
+        alignas(T) unsigned char storage[sizeof(T)];
+
+        sp_inplace_block() : base(&dispose_obj, &destroy_block) {}
+
+        T *object() { return reinterpret_cast<T *>(storage); }
+
+        static void dispose_obj(base *b) { tt::destroy(static_cast<sp_inplace_block *>(b)->object()); }
+        static void destroy_block(base *b){
+            sp_inplace_block *self = static_cast<sp_inplace_block *>(b);
+            self->~sp_inplace_block();
+            alloc::deallocate(self, sizeof(sp_inplace_block), alignof(sp_inplace_block));
         }
+    };
+
+    template<class T, class CountPolicy = atomic_count>
+    class WeakPtr;
+    template<class T, class CountPolicy = atomic_count>
+    class SharedPtr;
+    template<class T, class CountPolicy = atomic_count, class... Args>
+    SharedPtr<T, CountPolicy> make_shared(Args&&... args);
+
+    /*
+    **共享所有权的智能指针，控制块从tt::alloc分配
+    **默认使用atomic_count，不同线程各自持有的SharedPtr可以同时拷贝、析构；
+    **同一个SharedPtr对象本身的读写仍需要调用者同步
+    **优先使用make_shared：对象与控制块一次分配完成
+    */
+    template<class T, class CountPolicy>
+    class SharedPtr {
+    public:
+        typedef T                               element_type;
+        typedef WeakPtr<T, CountPolicy>         weak_type;
+    private:
+        typedef sp_control_block<CountPolicy>   control_block;
+
+        template<class U, class P> friend class SharedPtr;
+        template<class U, class P> friend class WeakPtr;
+        template<class U, class P, class... Args>
+        friend SharedPtr<U, P> make_shared(Args&&... args);
+
+        //接管已经计过数的控制块
+        SharedPtr(T *ptr, control_block *ctrl) noexcept : ptr_(ptr), ctrl_(ctrl) {}
+
+    public:
+        SharedPtr() noexcept : ptr_(0), ctrl_(0) {}
+        SharedPtr(std::nullptr_t) noexcept : ptr_(0), ctrl_(0) {}
+        //申请控制块失败时delete ptr后抛出异常
+        explicit SharedPtr(T *ptr);
+        SharedPtr(const SharedPtr &other) noexcept : ptr_(other.ptr_), ctrl_(other.ctrl_) {
+            if (ctrl_) ctrl_->add_ref();
+        }
+        SharedPtr(SharedPtr &&other) noexcept : ptr_(other.ptr_), ctrl_(other.ctrl_) {
+            other.ptr_ = 0;
+            other.ctrl_ = 0;
+        }
+        //派生类到基类的转换
+        template<class U, class = typename std::enable_if<std::is_convertible<U *, T *>::value>::type>
+        SharedPtr(const SharedPtr<U, CountPolicy> &other) noexcept : ptr_(other.ptr_), ctrl_(other.ctrl_) {
+            if (ctrl_) ctrl_->add_ref();
+        }
+        template<class U, class = typename std::enable_if<std::is_convertible<U *, T *>::value>::type>
+        SharedPtr(SharedPtr<U, CountPolicy> &&other) noexcept : ptr_(other.ptr_), ctrl_(other.ctrl_) {
+            other.ptr_ = 0;
+            other.ctrl_ = 0;
+        }
+        ~SharedPtr() {
+            if (ctrl_) ctrl_->release();
+        }
+
+        //先增加新的计数再释放旧的，自赋值、other由*this间接持有时都是安全的
+        SharedPtr& operator=(const SharedPtr &other) noexcept {
+            SharedPtr(other).swap(*this);
+            return *this;
+        }
+        SharedPtr& operator=(SharedPtr &&other) noexcept {
+            SharedPtr(std::move(other)).swap(*this);
+            return *this;
+        }
+
+        void swap(SharedPtr &other) noexcept {
+            tt::swap(ptr_, other.ptr_);
+            tt::swap(ctrl_, other.ctrl_);
+        }
+        void reset() noexcept { SharedPtr().swap(*this); }
+        void reset(T *ptr) { SharedPtr(ptr).swap(*this); }
+
+        T *get() const noexcept { return ptr_; }
+        T& operator*() const noexcept { return *ptr_; }
+        T* operator->() const noexcept { return ptr_; }
+        long use_count() const noexcept { return ctrl_ ? ctrl_->use_count() : 0; }
+        explicit operator bool() const noexcept { return ptr_ != 0; }
 
     private:
         T               *ptr_;
-        unsigned int    *cnt_;
+        control_block   *ctrl_;
     };
 
+    template<class T, class CountPolicy>
+    SharedPtr<T, CountPolicy>::SharedPtr(T *ptr) : ptr_(ptr), ctrl_(0) {
+        if (!ptr) {
+            return;
+        }
+        typedef sp_pointer_block<T, CountPolicy> block;
+        try {
+            ctrl_ = ::new(alloc::allocate(sizeof(block), alignof(block))) block(ptr);
+        }
+        catch (...) {
+            delete ptr;
+            throw;
+        }
+    }
+
+    template<class T, class U, class P>
+    inline bool operator==(const SharedPtr<T, P> &a, const SharedPtr<U, P> &b) { return a.get() == b.get(); }
+    template<class T, class U, class P>
+    inline bool operator!=(const SharedPtr<T, P> &a, const SharedPtr<U, P> &b) { return a.get() != b.get(); }
+    template<class T, class P>
+    inline bool operator==(const SharedPtr<T, P> &a, std::nullptr_t) { return !a; }
+    template<class T, class P>
+    inline bool operator!=(const SharedPtr<T, P> &a, std::nullptr_t) { return (bool)a; }
+
+    template<class T, class P>
+    inline void swap(SharedPtr<T, P> &a, SharedPtr<T, P> &b) noexcept { a.swap(b); }
+
+    /*
+    **在一次tt::alloc分配中构造控制块和对象：tt::make_shared<T>(args...)
+    **只在单个线程内使用的对象可以用tt::make_shared<T, tt::nonatomic_count>(args...)
+    */
+    template<class T, class CountPolicy, class... Args>
+    SharedPtr<T, CountPolicy> make_shared(Args&&... args){
+        typedef sp_inplace_block<T, CountPolicy> block;
+        void *mem = alloc::allocate(sizeof(block), alignof(block));
+        block *b = ::new(mem) block;
+        try {
+            construct(b->object(), std::forward<Args>(args)...);
+        }
+        catch (...) {
+            b->~block();
+            alloc::deallocate(mem, sizeof(block), alignof(block));
+            throw;
+        }
+        return SharedPtr<T, CountPolicy>(b->object(), b);
+    }
+
+
+    /*
+    **不拥有对象的观察者，只延长控制块的寿命
+    **lock()在对象仍然存活时得到一个SharedPtr，否则得到空指针；与最后一个SharedPtr的析构并发时也是安全的
+    */
+    template<class T, class CountPolicy>
+    class WeakPtr {
+    private:
+        typedef sp_control_block<CountPolicy>   control_block;
+
+        template<class U, class P> friend class WeakPtr;
+
+    public:
+        typedef T   element_type;
+
+        WeakPtr() noexcept : ptr_(0), ctrl_(0) {}
+        template<class U, class = typename std::enable_if<std::is_convertible<U *, T *>::value>::type>
+        WeakPtr(const SharedPtr<U, CountPolicy> &sp) noexcept : ptr_(sp.ptr_), ctrl_(sp.ctrl_) {
+            if (ctrl_) ctrl_->add_weak();
+        }
+        WeakPtr(const WeakPtr &other) noexcept : ptr_(other.ptr_), ctrl_(other.ctrl_) {
+            if (ctrl_) ctrl_->add_weak();
+        }
+        WeakPtr(WeakPtr &&other) noexcept : ptr_(other.ptr_), ctrl_(other.ctrl_) {
+            other.ptr_ = 0;
+            other.ctrl_ = 0;
+        }
+        ~WeakPtr() {
+            if (ctrl_) ctrl_->release_weak();
+        }
+
+        WeakPtr& operator=(const WeakPtr &other) noexcept {
+            WeakPtr(other).swap(*this);
+            return *this;
+        }
+        WeakPtr& operator=(WeakPtr &&other) noexcept {
+            WeakPtr(std::move(other)).swap(*this);
+            return *this;
+        }
+        WeakPtr& operator=(const SharedPtr<T, CountPolicy> &sp) noexcept {
+            WeakPtr(sp).swap(*this);
+            return *this;
+        }
+
+        void swap(WeakPtr &other) noexcept {
+            tt::swap(ptr_, other.ptr_);
+            tt::swap(ctrl_, other.ctrl_);
+        }
+        void reset() noexcept { WeakPtr().swap(*this); }
+
+        long use_count() const noexcept { return ctrl_ ? ctrl_->use_count() : 0; }
+        bool expired() const noexcept { return use_count() == 0; }
+        SharedPtr<T, CountPolicy> lock() const noexcept {
+            if (ctrl_ && ctrl_->add_ref_lock()) {
+                return SharedPtr<T, CountPolicy>(ptr_, ctrl_);
+            }
+            return SharedPtr<T, CountPolicy>();
+        }
+
+    private:
+        T               *ptr_;
+        control_block   *ctrl_;
+    };
+
+    //只保存两个指针，搬动后计数不受影响
+    template<class T, class P>
+    struct is_trivially_relocatable<SharedPtr<T, P>> : true_type {};
+    template<class T, class P>
+    struct is_trivially_relocatable<WeakPtr<T, P>> : true_type {};
+
+
+    /***************************************************************************/
+    /*
+    **计数嵌在对象里的引用计数基类，与intrusive_ptr配合使用：
+    **  struct node : tt::ref_counted<node> { ... };
+    **  tt::intrusive_ptr<node> p = tt::make_intrusive<node>(...);
+    **拷贝指针只修改对象自己的计数，不需要单独的控制块；CountPolicy同SharedPtr
+    **对象的new/delete走tt::alloc，计数减到0时用delete static_cast<T*>(this)析构，
+    **所以T应是最终的派生类，或者有虚析构函数
+    */
+    template<class T, class CountPolicy = atomic_count>
+    class ref_counted {
+    public:
+        long use_count() const noexcept { return CountPolicy::load(refs_); }
+
+        static void *operator new(size_t bytes) { return alloc::allocate(bytes); }
+        static void *operator new(size_t bytes, std::align_val_t align) { return alloc::allocate(bytes, (size_t)align); }
+        static void operator delete(void *ptr, size_t bytes) { alloc::deallocate(ptr, bytes); }
+        static void operator delete(void *ptr, size_t bytes, std::align_val_t align) {
+            alloc::deallocate(ptr, bytes, (size_t)align);
+        }
+
+    protected:
+        ref_counted() noexcept : refs_(0) {}
+        //拷贝出来的是新对象，计数从0开始；赋值不改变双方的计数
+        ref_counted(const ref_counted &) noexcept : refs_(0) {}
+        ref_counted& operator=(const ref_counted &) noexcept { return *this; }
+        ~ref_counted() {}
+
+    private:
+        //通过ADL供intrusive_ptr调用
+        friend void intrusive_ptr_add_ref(const ref_counted *p) noexcept { CountPolicy::increment(p->refs_); }
+        friend void intrusive_ptr_release(const ref_counted *p) noexcept {
+            if (CountPolicy::decrement(p->refs_)) {
+                delete static_cast<const T *>(p);
+            }
+        }
+
+        mutable typename CountPolicy::type refs_;
+    };
+
+    /*
+    **侵入式智能指针，只保存一个对象指针
+    **对象的计数通过ADL调用intrusive_ptr_add_ref(p)、intrusive_ptr_release(p)修改，
+    **ref_counted已经提供了这两个函数，别的类型自己定义后也可以使用
+    */
+    template<class T>
+    class intrusive_ptr {
+    public:
+        typedef T   element_type;
+
+        intrusive_ptr() noexcept : ptr_(0) {}
+        intrusive_ptr(std::nullptr_t) noexcept : ptr_(0) {}
+        //add_ref为false时接管调用者已经持有的一份计数
+        intrusive_ptr(T *ptr, bool add_ref = true) : ptr_(ptr) {
+            if (ptr_ && add_ref) intrusive_ptr_add_ref(ptr_);
+        }
+        intrusive_ptr(const intrusive_ptr &other) : ptr_(other.ptr_) {
+            if (ptr_) intrusive_ptr_add_ref(ptr_);
+        }
+        intrusive_ptr(intrusive_ptr &&other) noexcept : ptr_(other.ptr_) { other.ptr_ = 0; }
+        template<class U, class = typename std::enable_if<std::is_convertible<U *, T *>::value>::type>
+        intrusive_ptr(const intrusive_ptr<U> &other) : ptr_(other.get()) {
+            if (ptr_) intrusive_ptr_add_ref(ptr_);
+        }
+        template<class U, class = typename std::enable_if<std::is_convertible<U *, T *>::value>::type>
+        intrusive_ptr(intrusive_ptr<U> &&other) noexcept : ptr_(other.detach()) {}
+        ~intrusive_ptr() {
+            if (ptr_) intrusive_ptr_release(ptr_);
+        }
+
+        intrusive_ptr& operator=(const intrusive_ptr &other) {
+            intrusive_ptr(other).swap(*this);
+            return *this;
+        }
+        intrusive_ptr& operator=(intrusive_ptr &&other) noexcept {
+            intrusive_ptr(std::move(other)).swap(*this);
+            return *this;
+        }
+        intrusive_ptr& operator=(T *ptr) {
+            intrusive_ptr(ptr).swap(*this);
+            return *this;
+        }
+
+        void swap(intrusive_ptr &other) noexcept { tt::swap(ptr_, other.ptr_); }
+        void reset() noexcept { intrusive_ptr().swap(*this); }
+        void reset(T *ptr, bool add_ref = true) { intrusive_ptr(ptr, add_ref).swap(*this); }
+        //放弃所有权但不减少计数，返回对象指针
+        T *detach() noexcept {
+            T *p = ptr_;
+            ptr_ = 0;
+            return p;
+        }
+
+        T *get() const noexcept { return ptr_; }
+        T& operator*() const noexcept { return *ptr_; }
+        T* operator->() const noexcept { return ptr_; }
+        explicit operator bool() const noexcept { return ptr_ != 0; }
+
+    private:
+        T   *ptr_;
+    };
+
+    template<class T, class U>
+    inline bool operator==(const intrusive_ptr<T> &a, const intrusive_ptr<U> &b) { return a.get() == b.get(); }
+    template<class T, class U>
+    inline bool operator!=(const intrusive_ptr<T> &a, const intrusive_ptr<U> &b) { return a.get() != b.get(); }
+    template<class T>
+    inline bool operator==(const intrusive_ptr<T> &a, std::nullptr_t) { return !a; }
+    template<class T>
+    inline bool operator!=(const intrusive_ptr<T> &a, std::nullptr_t) { return (bool)a; }
+
+    template<class T>
+    inline void swap(intrusive_ptr<T> &a, intrusive_ptr<T> &b) noexcept { a.swap(b); }
+
+    //new T(args...)并交给intrusive_ptr，T继承ref_counted时内存来自tt::alloc
+    template<class T, class... Args>
+    inline intrusive_ptr<T> make_intrusive(Args&&... args) {
+        return intrusive_ptr<T>(new T(std::forward<Args>(args)...));
+    }
+
+    //只保存一个指针
+    template<class T>
+    struct is_trivially_relocatable<intrusive_ptr<T>> : true_type {};
+
 
 
 
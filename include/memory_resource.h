@@ -0,0 +1,184 @@
+//
+// Created on 2026/10/18.
+//
+
+#ifndef TINYSTL_MEMORY_RESOURCE_H
+#define TINYSTL_MEMORY_RESOURCE_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <atomic>
+#include <new>
+
+#include "alloc.h"
+#include "arena.h"
+
+
+namespace tt {
+
+    /*
+	**运行时可替换的内存来源
+	**容器的类型只与polymorphic_allocator有关，同一个tt::list<int, polymorphic_allocator<int>>
+	**可以在请求路径上用monotonic_resource，在其他地方用pool_resource，不必为每种内存来源各实例化一份代码
+	*/
+    class memory_resource{
+    public:
+        virtual ~memory_resource() {}
+
+        void *allocate(size_t bytes, size_t align = alignof(std::max_align_t)) { return do_allocate(bytes, align); }
+        void deallocate(void *ptr, size_t bytes, size_t align = alignof(std::max_align_t)) { do_deallocate(ptr, bytes, align); }
+        //由一方分配的内存能否交给另一方回收
+        bool is_equal(const memory_resource &other) const noexcept { return this == &other || do_is_equal(other); }
+
+    private:
+        virtual void *do_allocate(size_t bytes, size_t align) = 0;
+        virtual void do_deallocate(void *ptr, size_t bytes, size_t align) = 0;
+        virtual bool do_is_equal(const memory_resource &other) const noexcept = 0;
+    };
+
+    inline bool operator==(const memory_resource &a, const memory_resource &b) { return a.is_equal(b); }
+    inline bool operator!=(const memory_resource &a, const memory_resource &b) { return !a.is_equal(b); }
+
+
+    //tt::alloc的内存池，线程安全
+    class pool_resource : public memory_resource{
+    private:
+        void *do_allocate(size_t bytes, size_t align) override { return alloc::allocate(bytes, align); }
+        void do_deallocate(void *ptr, size_t bytes, size_t align) override { alloc::deallocate(ptr, bytes, align); }
+        //都是同一个内存池
+        bool do_is_equal(const memory_resource &other) const noexcept override {
+            return dynamic_cast<const pool_resource *>(&other) != 0;
+        }
+    };
+
+    //直接使用malloc/aligned_alloc，线程安全
+    class malloc_resource : public memory_resource{
+    private:
+        void *do_allocate(size_t bytes, size_t align) override;
+        void do_deallocate(void *ptr, size_t, size_t) override { free(ptr); }
+        bool do_is_equal(const memory_resource &other) const noexcept override {
+            return dynamic_cast<const malloc_resource *>(&other) != 0;
+        }
+    };
+
+    //任何分配都抛出std::bad_alloc，用来确认某段代码不会分配内存
+    class null_resource : public memory_resource{
+    private:
+        void *do_allocate(size_t, size_t) override { throw std::bad_alloc(); }
+        void do_deallocate(void *, size_t, size_t) override {}
+        bool do_is_equal(const memory_resource &other) const noexcept override { return this == &other; }
+    };
+
+    //从自己的monotonic_arena里分配，deallocate什么也不做，release()或析构时一次性收回
+    //不是线程安全的
+    class monotonic_resource : public memory_resource{
+    public:
+        monotonic_resource() {}
+        explicit monotonic_resource(size_t initial_block) : arena_(initial_block) {}
+
+        //收回所有分配出去的内存，保留最大的一块
+        void release() { arena_.reset(); }
+
+    private:
+        void *do_allocate(size_t bytes, size_t align) override { return arena_.allocate(bytes, align); }
+        void do_deallocate(void *, size_t, size_t) override {}
+        bool do_is_equal(const memory_resource &other) const noexcept override { return this == &other; }
+
+        monotonic_arena arena_;
+    };
+
+    inline void *malloc_resource::do_allocate(size_t bytes, size_t align) {
+        void *p = align <= alignof(std::max_align_t) ? malloc(bytes)
+                                                     : aligned_alloc(align, (bytes + align - 1) & ~(align - 1));
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        return p;
+    }
+
+    //三个无状态resource的全局实例，一直有效
+    inline memory_resource *get_pool_resource() {
+        static pool_resource r;
+        return &r;
+    }
+    inline memory_resource *get_malloc_resource() {
+        static malloc_resource r;
+        return &r;
+    }
+    inline memory_resource *get_null_resource() {
+        static null_resource r;
+        return &r;
+    }
+
+    //polymorphic_allocator默认构造时使用的resource，初始为get_pool_resource()
+    inline std::atomic<memory_resource *>& default_resource() {
+        static std::atomic<memory_resource *> r(get_pool_resource());
+        return r;
+    }
+    inline memory_resource *get_default_resource() {
+        return default_resource().load(std::memory_order_acquire);
+    }
+    //r为0时恢复为get_pool_resource()，返回原来的resource
+    inline memory_resource *set_default_resource(memory_resource *r) {
+        return default_resource().exchange(r ? r : get_pool_resource(), std::memory_order_acq_rel);
+    }
+
+
+    /*
+	**通过memory_resource分配的空间配置器，可作为list、deque、vector的Alloc参数
+	**实例保存所用resource的指针，默认构造时取get_default_resource()
+	**拷贝构造容器时新容器使用默认resource；容器赋值、交换时allocator不跟着转移(同std::pmr)
+	*/
+    template<class T>
+    class polymorphic_allocator{
+    public:
+        typedef T			value_type;
+        typedef T*			pointer;
+        typedef const T*	const_pointer;
+        typedef T&			reference;
+        typedef const T&	const_reference;
+        typedef size_t		size_type;
+        typedef ptrdiff_t	difference_type;
+    public:
+        polymorphic_allocator() noexcept : resource_(get_default_resource()) {}
+        polymorphic_allocator(memory_resource *r) noexcept : resource_(r) {}
+        template<class U>
+        polymorphic_allocator(const polymorphic_allocator<U> &other) noexcept : resource_(other.resource()) {}
+
+        T *allocate(size_t n) {
+            if (n == 0) return 0;
+            return static_cast<T *>(resource_->allocate(sizeof(T) * n, alignof(T)));
+        }
+        void deallocate(T *ptr, size_t n) {
+            if (n == 0) return;
+            resource_->deallocate(ptr, sizeof(T) * n, alignof(T));
+        }
+
+        polymorphic_allocator select_on_container_copy_construction() const { return polymorphic_allocator(); }
+
+        memory_resource *resource() const { return resource_; }
+
+        template<class U>
+        struct rebind{
+            using other = polymorphic_allocator<U>;
+        };
+
+    private:
+        memory_resource *resource_;
+    };
+
+    template<class T, class U>
+    bool operator==(const polymorphic_allocator<T> &a, const polymorphic_allocator<U> &b) {
+        return *a.resource() == *b.resource();
+    }
+    template<class T, class U>
+    bool operator!=(const polymorphic_allocator<T> &a, const polymorphic_allocator<U> &b) {
+        return !(a == b);
+    }
+
+
+}  // namespace tt
+
+
+
+#endif //TINYSTL_MEMORY_RESOURCE_H
@@ -0,0 +1,124 @@
+//
+// Created on 2026/10/18.
+//
+
+#ifndef TINYSTL_RCU_H
+#define TINYSTL_RCU_H
+
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+#include "reclaim.h"
+
+
+namespace tt {
+
+    /*
+	**RCU(read-copy-update)的读临界区与宽限期，由ebr实现：
+	**读者用rcu::read_guard标出读临界区，进出各写一次本线程独占的记录，不加锁，可以嵌套；
+	**Linux上借助membarrier，读者一侧只有一次load、一次普通的store和编译器屏障
+	**写者换上新版本后用retire()交出旧版本，宽限期过后析构
+	*/
+    class rcu{
+    public:
+        typedef ebr::guard read_guard;
+
+        static void read_lock() { ebr::enter(); }
+        static void read_unlock() { ebr::leave(); }
+        //宽限期过后调用deleter(p)；可以在读临界区内调用
+        static void retire(void *p, void (*deleter)(void *)) { ebr::retire(p, deleter); }
+        //宽限期过后delete p
+        template<class T>
+        static void retire(T *p) { ebr::retire(p); }
+        //等到调用之前进入的读临界区全部结束，不能在读临界区内调用
+        static void synchronize() { ebr::synchronize(); }
+    };
+
+
+    /*
+	**RCU保护的指针，适合读多写少、整体替换的数据(路由表、配置等)：
+	**  tt::rcu_ptr<table> routes(new table(...));
+	**  读者：tt::rcu_ptr<table>::snapshot s = routes.read(); s->lookup(...);
+	**  写者：routes.store(new_table); 或 routes.update([](table& t){ ... });
+	**读者拿到的快照在snapshot析构前一直有效，读取只是进入临界区和一次load
+	**被替换下来的版本在宽限期过后delete
+	**需要C++17：snapshot不能拷贝也不能移动，read()按值返回它靠的是C++17保证的复制消除
+	*/
+    template<class T>
+    class rcu_ptr{
+    public:
+        //读临界区加上其中读到的指针；guard_不能移动，所以snapshot只能由read()直接构造在调用处
+        class snapshot{
+        public:
+            const T *get() const noexcept { return ptr_; }
+            const T& operator*() const noexcept { return *ptr_; }
+            const T* operator->() const noexcept { return ptr_; }
+            explicit operator bool() const noexcept { return ptr_ != 0; }
+
+        private:
+            friend class rcu_ptr;
+            explicit snapshot(const rcu_ptr &p) : ptr_(p.load()) {}
+
+            rcu::read_guard guard_;  //先于ptr_构造
+            const T         *ptr_;
+        };
+
+    public:
+        rcu_ptr() noexcept : ptr_(0) {}
+        explicit rcu_ptr(T *ptr) noexcept : ptr_(ptr) {}
+        rcu_ptr(const rcu_ptr &) = delete;
+        rcu_ptr& operator=(const rcu_ptr &) = delete;
+        //此时不应再有读者，直接delete当前版本
+        ~rcu_ptr() { delete ptr_.load(std::memory_order_relaxed); }
+
+        snapshot read() const { return snapshot(*this); }
+        //只能在读临界区内调用，返回的指针在离开临界区之前有效
+        const T *load() const noexcept { return ptr_.load(std::memory_order_acquire); }
+
+        //换上ptr，旧版本在宽限期过后delete
+        void store(T *ptr) {
+            std::lock_guard<std::mutex> guard(write_lock_);
+            publish(ptr);
+        }
+        template<class... Args>
+        void emplace(Args&&... args) { store(new T(std::forward<Args>(args)...)); }
+        //拷贝当前版本，用f修改副本后换上；多个写者之间互斥，读者不受影响
+        template<class F>
+        void update(F f);
+
+    private:
+        //调用者持有write_lock_
+        void publish(T *ptr) {
+            T *old = ptr_.exchange(ptr, std::memory_order_acq_rel);
+            if (old){
+                rcu::retire(old);
+            }
+        }
+
+        std::atomic<T *>    ptr_;
+        std::mutex          write_lock_;
+    };
+
+    template<class T>
+    template<class F>
+    void rcu_ptr<T>::update(F f) {
+        std::lock_guard<std::mutex> guard(write_lock_);
+        const T *cur = ptr_.load(std::memory_order_relaxed);  //只有持锁的写者会修改ptr_
+        T *next = cur ? new T(*cur) : new T();
+        try {
+            f(*next);
+        }
+        catch (...) {
+            delete next;
+            throw;
+        }
+        publish(next);
+    }
+
+
+}  // namespace tt
+
+
+
+#endif //TINYSTL_RCU_H
@@ -0,0 +1,668 @@
+//
+// Created on 2026/10/18.
+//
+
+#ifndef TINYSTL_RECLAIM_H
+#define TINYSTL_RECLAIM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <new>
+#include <algorithm>
+#include <type_traits>
+
+#include "alloc.h"
+#include "vector.h"
+
+#if defined(__has_include)
+#if defined(__linux__) && __has_include(<linux/membarrier.h>)
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/membarrier.h>
+#define TINYSTL_HAVE_MEMBARRIER
+#endif
+#endif
+
+
+namespace tt {
+
+    /*
+	**无锁数据结构的延迟回收(deferred reclamation)
+	**从结构中摘下的节点可能仍被别的线程读着，先交给回收器，确认没有线程还能访问时再释放。两种回收器：
+	**  ebr：基于epoch，读者进出临界区各写一次本线程的记录，开销最小；
+	**       但一个长时间停在临界区里的线程会让所有回收都停下来
+	**  hazard_pointer：读者逐个登记正在访问的节点，只有被登记的节点推迟回收，
+	**       未回收的节点数有上限，不受慢线程影响，每访问一个节点多一次store
+	**两者都在每个线程里攒够一批才回收；用retire_node、retire_raw交出的tt::alloc内存，
+	**以及记录待回收对象的节点本身，都按大小用alloc::deallocate_batch成批归还
+	*/
+
+    /*
+	**非对称内存屏障：频繁执行的一侧(读者)调用light()，只是编译器屏障；
+	**偶尔执行的一侧(回收者)调用heavy()，用membarrier让所有正在运行本进程线程的CPU都执行一次完整的内存屏障，
+	**两侧合起来相当于各自执行了一次seq_cst屏障
+	**membarrier不可用时两侧都是seq_cst屏障
+	*/
+    class asymmetric_fence{
+    public:
+        static void light(){
+            if (membarrier()){
+                std::atomic_signal_fence(std::memory_order_seq_cst);
+            }
+            else{
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+        }
+        static void heavy();
+
+    private:
+        //第一次调用时查询并注册membarrier，返回能否使用
+        static bool membarrier(){
+            static const bool registered = register_membarrier();
+            return registered;
+        }
+        static bool register_membarrier();
+    };
+
+    inline bool asymmetric_fence::register_membarrier(){
+#ifdef TINYSTL_HAVE_MEMBARRIER
+        long cmds = syscall(__NR_membarrier, MEMBARRIER_CMD_QUERY, 0, 0);
+        return cmds > 0 && (cmds & MEMBARRIER_CMD_PRIVATE_EXPEDITED) &&
+               syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0, 0) == 0;
+#else
+        return false;
+#endif
+    }
+    inline void asymmetric_fence::heavy(){
+#ifdef TINYSTL_HAVE_MEMBARRIER
+        if (membarrier()){
+            syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0, 0);
+            return;
+        }
+#endif
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+
+    /*
+	**等待回收的对象组成的单链表，节点从tt::alloc分配；只被一个线程使用
+	**每个对象释放时先调用dtor(ptr)，bytes不为0时再把内存还给tt::alloc，
+	**相邻的同样大小、同样对齐的内存一次交给alloc::deallocate_batch
+	*/
+    class retire_list{
+    private:
+        struct node{
+            void *ptr;
+            void (*dtor)(void *);  //为0表示不需要析构
+            size_t bytes;          //为0表示内存已经由dtor回收
+            size_t align;
+            node *next;
+        };
+
+        //攒着同样大小、同样对齐的区块，满了或者大小变了时一起归还
+        class free_batch{
+        public:
+            free_batch() : n_(0), bytes_(0), align_(0) {}
+            ~free_batch() { flush(); }
+
+            void add(void *ptr, size_t bytes, size_t align){
+                if (n_ == EBatch::BATCH || (n_ && (bytes != bytes_ || align != align_))){
+                    flush();
+                }
+                bytes_ = bytes;
+                align_ = align;
+                ptrs_[n_++] = ptr;
+            }
+            void flush(){
+                if (n_){
+                    alloc::deallocate_batch(ptrs_, n_, bytes_, align_);
+                    n_ = 0;
+                }
+            }
+
+        private:
+            enum EBatch{ BATCH = 64};
+
+            void    *ptrs_[EBatch::BATCH];
+            size_t  n_;
+            size_t  bytes_;
+            size_t  align_;
+        };
+
+    public:
+        //常用的dtor
+        template<class T>
+        static void delete_object(void *p) { delete static_cast<T *>(p); }
+        template<class T>
+        static void destroy_object(void *p) { static_cast<T *>(p)->~T(); }
+        //从alloc::allocate(sizeof(T), alignof(T))分配的T回收时用的dtor，平凡析构时不需要
+        template<class T>
+        static void (*node_dtor())(void *) {
+            return std::is_trivially_destructible<T>::value ? 0 : &destroy_object<T>;
+        }
+
+        retire_list() noexcept : head_(0), tail_(0), size_(0) {}
+
+        bool empty() const { return head_ == 0; }
+        size_t size() const { return size_; }
+
+        void push(void *ptr, void (*dtor)(void *), size_t bytes, size_t align);
+        //把other的对象全部移到这里
+        void splice(retire_list& other);
+        //释放全部对象
+        void reclaim();
+        //释放keep(ptr)为false的对象，其余的留在表里
+        template<class Pred>
+        void reclaim_unless(Pred keep);
+
+    private:
+        //析构对象，内存交给batch
+        static void release(node *n, free_batch& batch){
+            if (n->dtor){
+                n->dtor(n->ptr);
+            }
+            if (n->bytes){
+                batch.add(n->ptr, n->bytes, n->align);
+            }
+        }
+
+        node    *head_;
+        node    *tail_;
+        size_t  size_;
+    };
+
+    inline void retire_list::push(void *ptr, void (*dtor)(void *), size_t bytes, size_t align){
+        node *n = static_cast<node *>(alloc::allocate(sizeof(node)));
+        n->ptr = ptr;
+        n->dtor = dtor;
+        n->bytes = bytes;
+        n->align = align;
+        n->next = head_;
+        if (!head_){
+            tail_ = n;
+        }
+        head_ = n;
+        ++size_;
+    }
+
+    inline void retire_list::splice(retire_list& other){
+        if (!other.head_){
+            return;
+        }
+        other.tail_->next = head_;
+        if (!head_){
+            tail_ = other.tail_;
+        }
+        head_ = other.head_;
+        size_ += other.size_;
+        other.head_ = other.tail_ = 0;
+        other.size_ = 0;
+    }
+
+    inline void retire_list::reclaim(){
+        //析构函数里可能又往这里push，先把链表摘下来
+        node *p = head_;
+        head_ = tail_ = 0;
+        size_ = 0;
+        free_batch objs, nodes;
+        while (p){
+            node *next = p->next;
+            release(p, objs);
+            nodes.add(p, sizeof(node), 1);
+            p = next;
+        }
+    }
+
+    template<class Pred>
+    void retire_list::reclaim_unless(Pred keep){
+        node *p = head_;
+        head_ = tail_ = 0;
+        size_ = 0;
+        free_batch objs, nodes;
+        while (p){
+            node *next = p->next;
+            if (keep(p->ptr)){
+                p->next = head_;
+                if (!head_){
+                    tail_ = p;
+                }
+                head_ = p;
+                ++size_;
+            }
+            else{
+                release(p, objs);
+                nodes.add(p, sizeof(node), 1);
+            }
+            p = next;
+        }
+    }
+
+
+    /*
+	**基于epoch的回收(epoch-based reclamation)
+	**读者用ebr::guard标出临界区：进入时把全局epoch写进本线程独占一条cache line的记录，离开时清零；
+	**不加锁，不写别的线程会写的cache line，临界区可以嵌套
+	**  全局epoch从e推进到e+1，要求所有处在临界区中的线程都是在epoch e进入的；
+	**  在epoch e被retire的对象，全局epoch到达e+2时已经没有读者能看到它了
+	**每个线程把retire的对象按epoch%3分到三个袋子里，攒够RETIRE_BATCH个时尝试推进epoch并回收，
+	**synchronize()则一直等到宽限期结束；退出的线程留下的对象交给之后回收的线程处理
+	*/
+    class ebr{
+    private:
+        enum ERetireBatch{ RETIRE_BATCH = 64};  //每retire这么多个对象尝试推进一次epoch
+        enum ECacheLine{ CACHE_LINE = 64};
+        enum EBags{ BAGS = 3};
+
+        //同一个epoch里retire的对象
+        struct bag{
+            uint64_t epoch;
+            retire_list objs;
+        };
+        //退出的线程留下的袋子
+        struct orphan_bag{
+            bag objs;
+            orphan_bag *next;
+        };
+
+        //线程的读者记录，各占一条cache line；一经创建就不释放，线程退出后留给新线程接管
+        struct alignas(ECacheLine::CACHE_LINE) record{
+            std::atomic<uint64_t> epoch;  //进入临界区时的全局epoch，0表示不在临界区
+            std::atomic<bool> in_use;
+            record *next;                 //所有记录串成单链表，只在表头插入
+        };
+
+        //线程私有的状态
+        struct thread_state{
+            record *rec;
+            unsigned nest;   //临界区的嵌套层数
+            size_t pending;  //上次尝试回收之后retire的对象数
+            bag bags[EBags::BAGS];
+
+            thread_state();
+            ~thread_state();  //线程退出时回收能回收的对象，其余交给orphans
+        };
+
+        static inline thread_local thread_state tstate;
+        alignas(ECacheLine::CACHE_LINE) static inline std::atomic<uint64_t> global_epoch{1};
+        static inline std::atomic<record *> records{0};
+        static inline std::mutex orphan_lock;  //保护orphans
+        static inline std::atomic<orphan_bag *> orphans{0};
+
+        //取得一条空闲的记录，没有就新建一条
+        static record *acquire_record();
+        //所有处在临界区中的线程都已进入当前epoch时把全局epoch加1，返回之后的全局epoch
+        static uint64_t try_advance();
+        //回收ts中、以及退出的线程留下的已过宽限期的对象，e为当前的全局epoch
+        static void collect(thread_state& ts, uint64_t e);
+        static void defer(void *p, void (*dtor)(void *), size_t bytes, size_t align);
+
+    public:
+        static void enter();
+        static void leave();
+
+        //在作用域内处于临界区
+        class guard{
+        public:
+            guard() { enter(); }
+            ~guard() { leave(); }
+            guard(const guard &) = delete;
+            guard& operator=(const guard &) = delete;
+        };
+
+        //以下retire都可以在临界区内调用，p必须已经从共享结构中摘下
+        //宽限期过后delete p
+        template<class T>
+        static void retire(T *p) { defer(p, &retire_list::delete_object<T>, 0, 0); }
+        //宽限期过后调用deleter(p)
+        static void retire(void *p, void (*deleter)(void *)) { defer(p, deleter, 0, 0); }
+        //p由alloc::allocate(sizeof(T), alignof(T))分配：宽限期过后析构，内存成批还给tt::alloc
+        template<class T>
+        static void retire_node(T *p) { defer(p, retire_list::node_dtor<T>(), sizeof(T), alignof(T)); }
+        //p由alloc::allocate(bytes, align)分配：宽限期过后成批还给tt::alloc
+        static void retire_raw(void *p, size_t bytes, size_t align = 1) { defer(p, 0, bytes, align); }
+        //等到调用之前进入的临界区全部结束，并回收本线程已过宽限期的对象
+        //不能在临界区内调用，否则永远等不到
+        static void synchronize();
+    };
+
+
+    inline ebr::thread_state::thread_state() : rec(acquire_record()), nest(0), pending(0) {
+        for (size_t i = 0; i < EBags::BAGS; ++i){
+            bags[i].epoch = 0;
+        }
+    }
+    inline ebr::thread_state::~thread_state(){
+        //没有别的读者时推进两次就能回收全部对象
+        try_advance();
+        uint64_t e = try_advance();
+        collect(*this, e);
+        for (size_t i = 0; i < EBags::BAGS; ++i){
+            if (!bags[i].objs.empty()){
+                orphan_bag *o = ::new(alloc::allocate(sizeof(orphan_bag))) orphan_bag;
+                o->objs.epoch = bags[i].epoch;
+                o->objs.objs.splice(bags[i].objs);
+                std::lock_guard<std::mutex> guard(orphan_lock);
+                o->next = orphans.load(std::memory_order_relaxed);
+                orphans.store(o, std::memory_order_release);
+            }
+        }
+        rec->in_use.store(false, std::memory_order_release);
+    }
+
+    inline ebr::record *ebr::acquire_record(){
+        for (record *r = records.load(std::memory_order_acquire); r; r = r->next){
+            bool expected = false;
+            if (!r->in_use.load(std::memory_order_relaxed) &&
+                r->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)){
+                return r;
+            }
+        }
+        record *r = ::new(alloc::allocate(sizeof(record), alignof(record))) record;
+        r->epoch.store(0, std::memory_order_relaxed);
+        r->in_use.store(true, std::memory_order_relaxed);
+        r->next = records.load(std::memory_order_relaxed);
+        while (!records.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed)){
+        }
+        return r;
+    }
+
+    /*
+    **读者先写记录再读共享指针，回收者先摘下节点再扫描记录：
+    **读者读到了已摘下的节点的话，它的记录一定能被扫描看到，宽限期会等它离开
+    **两边的store-load顺序由asymmetric_fence保证，读者一侧只是编译器屏障
+    */
+    inline void ebr::enter(){
+        thread_state& ts = tstate;
+        if (ts.nest++ == 0){
+            ts.rec->epoch.store(global_epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            asymmetric_fence::light();
+        }
+    }
+    inline void ebr::leave(){
+        thread_state& ts = tstate;
+        if (--ts.nest == 0){
+            ts.rec->epoch.store(0, std::memory_order_release);
+        }
+    }
+
+    inline uint64_t ebr::try_advance(){
+        asymmetric_fence::heavy();
+        uint64_t e = global_epoch.load(std::memory_order_acquire);
+        for (record *r = records.load(std::memory_order_acquire); r; r = r->next){
+            uint64_t re = r->epoch.load(std::memory_order_acquire);
+            if (re != 0 && re != e){
+                return e;
+            }
+        }
+        //失败说明别的线程已经推进过了，e被更新为当前值
+        if (global_epoch.compare_exchange_strong(e, e + 1, std::memory_order_acq_rel)){
+            return e + 1;
+        }
+        return e;
+    }
+
+    inline void ebr::collect(thread_state& ts, uint64_t e){
+        for (size_t i = 0; i < EBags::BAGS; ++i){
+            if (!ts.bags[i].objs.empty() && ts.bags[i].epoch + 2 <= e){
+                ts.bags[i].objs.reclaim();
+            }
+        }
+        if (!orphans.load(std::memory_order_acquire)){
+            return;
+        }
+        orphan_bag *ready = 0;
+        {
+            std::lock_guard<std::mutex> guard(orphan_lock);
+            orphan_bag *keep = 0;
+            for (orphan_bag *o = orphans.load(std::memory_order_relaxed); o; ){
+                orphan_bag *next = o->next;
+                if (o->objs.epoch + 2 <= e){
+                    o->next = ready;
+                    ready = o;
+                }
+                else{
+                    o->next = keep;
+                    keep = o;
+                }
+                o = next;
+            }
+            orphans.store(keep, std::memory_order_release);
+        }
+        while (ready){
+            orphan_bag *next = ready->next;
+            ready->objs.objs.reclaim();
+            alloc::deallocate(ready, sizeof(orphan_bag));
+            ready = next;
+        }
+    }
+
+    inline void ebr::defer(void *p, void (*dtor)(void *), size_t bytes, size_t align){
+        thread_state& ts = tstate;
+        //摘下节点的store要先于读取epoch，否则可能读到过时的epoch，过早回收
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint64_t e = global_epoch.load(std::memory_order_relaxed);
+        bag& b = ts.bags[e % EBags::BAGS];
+        if (b.epoch != e){//袋子里是至少三个epoch之前的对象，早已过了宽限期
+            b.objs.reclaim();
+            b.epoch = e;
+        }
+        b.objs.push(p, dtor, bytes, align);
+        if (++ts.pending >= ERetireBatch::RETIRE_BATCH){
+            ts.pending = 0;
+            collect(ts, try_advance());
+        }
+    }
+
+    inline void ebr::synchronize(){
+        uint64_t target = global_epoch.load(std::memory_order_acquire) + 2;
+        uint64_t e;
+        while ((e = try_advance()) < target){
+            std::this_thread::yield();
+        }
+        thread_state& ts = tstate;
+        ts.pending = 0;
+        collect(ts, e);
+    }
+
+
+    /*
+	**风险指针(hazard pointer)
+	**读者用holder登记即将访问的节点：
+	**  tt::hazard_pointer::holder h;
+	**  node *n = h.protect(head);  //此后n不会被回收，直到h.clear()、再次protect或h析构
+	**retire的对象攒够一批时扫描所有线程登记的指针，未被登记的立即回收，其余留到下次
+	**每个线程按需取得记录，每条记录有SLOTS个槽，占两条cache line，只有所属线程写
+	**retire时交出的指针要与protect时登记的相同(多重继承时注意指针调整)
+	*/
+    class hazard_pointer{
+    private:
+        enum ESlots{ SLOTS = 8};                //每条记录的槽数
+        enum ERetireBatch{ RETIRE_BATCH = 64};  //retire的对象至少攒到这么多个才扫描
+        enum ECacheLine{ CACHE_LINE = 64};
+
+        //一经创建就不释放，线程退出后留给新线程接管
+        struct alignas(ECacheLine::CACHE_LINE) record{
+            std::atomic<const void *> slots[ESlots::SLOTS];
+            std::atomic<bool> in_use;
+            record *next;        //所有记录串成单链表，只在表头插入
+            record *owned_next;  //同一个线程持有的下一条记录
+            unsigned free_mask;  //空闲的槽，只被所属线程访问
+        };
+
+        //线程私有的状态
+        struct thread_state{
+            record *owned;                  //本线程持有的记录
+            retire_list retired;
+            vector<const void *> hazards;   //扫描时收集登记的指针
+
+            thread_state() : owned(0) {}
+            ~thread_state();  //线程退出时扫描一次，回收不了的交给orphans
+        };
+
+        static inline thread_local thread_state tstate;
+        static inline std::atomic<record *> records{0};
+        static inline std::atomic<size_t> nrecords{0};
+        static inline std::mutex orphan_lock;  //保护orphans
+        static inline retire_list orphans;
+        static inline std::atomic<bool> has_orphans{false};
+
+        //取得一条空闲的记录，没有就新建一条
+        static record *acquire_record();
+        //本线程的一个空闲槽
+        static std::atomic<const void *> *acquire_slot();
+        static void release_slot(std::atomic<const void *> *slot);
+        static void defer(void *p, void (*dtor)(void *), size_t bytes, size_t align);
+        //回收ts.retired与orphans中没有被登记的对象
+        static void scan(thread_state& ts);
+
+    public:
+        //占用一个槽；只能在创建它的线程里使用
+        class holder{
+        public:
+            holder() : slot_(acquire_slot()) {}
+            ~holder() { release_slot(slot_); }
+            holder(const holder &) = delete;
+            holder& operator=(const holder &) = delete;
+
+            //读取src并登记，返回的指针在clear()、再次登记或析构之前不会被回收
+            template<class T>
+            T *protect(const std::atomic<T *>& src){
+                T *p = src.load(std::memory_order_relaxed);
+                for (;;){
+                    reset(p);
+                    T *q = src.load(std::memory_order_acquire);
+                    if (q == p){
+                        return p;
+                    }
+                    p = q;
+                }
+            }
+            //直接登记p，调用者要自己确认p在登记之后仍然没有被摘下
+            void reset(const void *p){
+                slot_->store(p, std::memory_order_relaxed);
+                asymmetric_fence::light();
+            }
+            void clear() { slot_->store(0, std::memory_order_release); }
+
+        private:
+            std::atomic<const void *> *slot_;
+        };
+
+        //以下同ebr，p必须已经从共享结构中摘下
+        template<class T>
+        static void retire(T *p) { defer(p, &retire_list::delete_object<T>, 0, 0); }
+        static void retire(void *p, void (*deleter)(void *)) { defer(p, deleter, 0, 0); }
+        template<class T>
+        static void retire_node(T *p) { defer(p, retire_list::node_dtor<T>(), sizeof(T), alignof(T)); }
+        static void retire_raw(void *p, size_t bytes, size_t align = 1) { defer(p, 0, bytes, align); }
+        //立即扫描一次，回收本线程与退出的线程留下的、没有被登记的对象
+        static void reclaim() { scan(tstate); }
+    };
+
+    inline hazard_pointer::thread_state::~thread_state(){
+        scan(*this);
+        if (!retired.empty()){
+            std::lock_guard<std::mutex> guard(orphan_lock);
+            orphans.splice(retired);
+            has_orphans.store(true, std::memory_order_release);
+        }
+        for (record *r = owned; r; r = r->owned_next){
+            r->in_use.store(false, std::memory_order_release);
+        }
+    }
+
+    inline hazard_pointer::record *hazard_pointer::acquire_record(){
+        for (record *r = records.load(std::memory_order_acquire); r; r = r->next){
+            bool expected = false;
+            if (!r->in_use.load(std::memory_order_relaxed) &&
+                r->in_use.compare_exchange_strong(expected, true, std::memory_order_acquire)){
+                return r;
+            }
+        }
+        record *r = ::new(alloc::allocate(sizeof(record), alignof(record))) record;
+        for (size_t i = 0; i < ESlots::SLOTS; ++i){
+            r->slots[i].store(0, std::memory_order_relaxed);
+        }
+        r->in_use.store(true, std::memory_order_relaxed);
+        r->next = records.load(std::memory_order_relaxed);
+        while (!records.compare_exchange_weak(r->next, r, std::memory_order_release, std::memory_order_relaxed)){
+        }
+        nrecords.fetch_add(1, std::memory_order_relaxed);
+        return r;
+    }
+
+    inline std::atomic<const void *> *hazard_pointer::acquire_slot(){
+        thread_state& ts = tstate;
+        record *r = ts.owned;
+        while (r && !r->free_mask){
+            r = r->owned_next;
+        }
+        if (!r){
+            r = acquire_record();
+            r->free_mask = (1u << ESlots::SLOTS) - 1;
+            r->owned_next = ts.owned;
+            ts.owned = r;
+        }
+        size_t i = 0;
+        while (!(r->free_mask & (1u << i))){
+            ++i;
+        }
+        r->free_mask &= ~(1u << i);
+        return &r->slots[i];
+    }
+
+    inline void hazard_pointer::release_slot(std::atomic<const void *> *slot){
+        slot->store(0, std::memory_order_release);
+        for (record *r = tstate.owned; r; r = r->owned_next){
+            if (slot >= r->slots && slot < r->slots + ESlots::SLOTS){
+                r->free_mask |= 1u << (slot - r->slots);
+                return;
+            }
+        }
+    }
+
+    inline void hazard_pointer::defer(void *p, void (*dtor)(void *), size_t bytes, size_t align){
+        thread_state& ts = tstate;
+        ts.retired.push(p, dtor, bytes, align);
+        //登记的指针至多nrecords * SLOTS个，攒到它的两倍以上时每次扫描至少能回收一半
+        if (ts.retired.size() >= ERetireBatch::RETIRE_BATCH + 2 * ESlots::SLOTS * nrecords.load(std::memory_order_relaxed)){
+            scan(ts);
+        }
+    }
+
+    inline void hazard_pointer::scan(thread_state& ts){
+        if (has_orphans.load(std::memory_order_acquire)){
+            std::lock_guard<std::mutex> guard(orphan_lock);
+            ts.retired.splice(orphans);
+            has_orphans.store(false, std::memory_order_relaxed);
+        }
+        if (ts.retired.empty()){
+            return;
+        }
+        //摘下节点在前、读取槽在后，读者登记之后重新读到的不会是已摘下的节点
+        asymmetric_fence::heavy();
+        ts.hazards.clear();
+        for (record *r = records.load(std::memory_order_acquire); r; r = r->next){
+            for (size_t i = 0; i < ESlots::SLOTS; ++i){
+                const void *p = r->slots[i].load(std::memory_order_acquire);
+                if (p){
+                    ts.hazards.push_back(p);
+                }
+            }
+        }
+        std::sort(ts.hazards.begin(), ts.hazards.end());
+        const vector<const void *>& hazards = ts.hazards;
+        ts.retired.reclaim_unless([&hazards](void *p) {
+            return std::binary_search(hazards.begin(), hazards.end(), static_cast<const void *>(p));
+        });
+    }
+
+
+}  // namespace tt
+
+
+
+#endif //TINYSTL_RECLAIM_H
@@ -0,0 +1,355 @@
+//
+// Created on 2026/10/18.
+//
+
+#ifndef TINYSTL_SLAB_H
+#define TINYSTL_SLAB_H
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <new>
+
+#include "alloc.h"
+
+
+namespace tt {
+
+    /*
+	**按类型划分的slab空间配置器，主要给list分配节点用：tt::list<T, tt::slab_allocator<T>>
+	**每个T有自己的slab：一块按自身大小对齐的连续内存，开头是引用计数和空闲位图，后面是一格格的T。
+	**由节点地址把低位清零就得到所在的slab，位图中置1的位表示空闲的格子。
+	**
+	**allocate(1, hint)优先在hint所在slab里、紧跟hint之后的格子分配，
+	**list插入节点时以前一个节点为hint，一条链上的节点因此大多落在同一个slab的相邻格子里，
+	**遍历时基本是顺序访问内存，不会和别的容器交替分配的区块混在一起。
+	**没有hint或hint所在的slab已满时，从当前线程的slab里分配。
+	**当前slab满了就挂到本线程的partial链表末尾，再从链表前面几块里找有空格子的接着用，都没有才新建一块，
+	**这样零散存活的节点不会让slab里其余的格子一直闲置。
+	**
+	**位图和引用计数都是原子的，任何线程都可以直接分配(按hint)、回收，不需要转交给所属线程。
+	**slab的引用计数 = 存活的节点数 + 1(是某个线程的当前slab或在它的partial链表上时)，降为0时整块还给tt::alloc。
+	**线程退出时交出当前slab和partial链表；之后(更晚析构的thread_local里)没有hint的分配每次新建一块slab，只由其中的节点持有。
+	**一次分配多个T(n != 1)时直接交给tt::alloc。
+	*/
+    template<class T>
+    class slab_allocator{
+    private:
+        enum EMinSlabBytes{ MIN_SLAB_BYTES = 16384};  //slab的最小大小
+        enum EMinSlots{ MIN_SLOTS = 64};              //每个slab至少放这么多个T
+        enum EWordBits{ WORD_BITS = 64};
+        enum EPartialProbes{ PARTIAL_PROBES = 8};     //当前slab满了时，在partial链表前面最多看这么多块
+
+        static constexpr size_t slab_bytes(){
+            size_t bytes = EMinSlabBytes::MIN_SLAB_BYTES;
+            while (bytes < 2 * EMinSlots::MIN_SLOTS * sizeof(T)){
+                bytes *= 2;
+            }
+            return bytes;
+        }
+        enum ESlabBytes{ SLAB_BYTES = slab_bytes()};  //slab的大小，也是它的对齐
+        enum ENWords{ NWORDS = SLAB_BYTES / sizeof(T) / WORD_BITS + 1};  //位图的字数(上界)
+
+        struct slab{
+            std::atomic<size_t> refs;
+            std::atomic<uint64_t> free_bits[NWORDS];
+            slab *next_partial;  //在所属线程的partial链表上时指向下一块，只有该线程读写
+        };
+        static constexpr size_t first_offset(){
+            return (sizeof(slab) + alignof(T) - 1) & ~(alignof(T) - 1);
+        }
+        static constexpr size_t slot_count(){
+            return (SLAB_BYTES - first_offset()) / sizeof(T) < (size_t)NWORDS * WORD_BITS
+                   ? (SLAB_BYTES - first_offset()) / sizeof(T) : (size_t)NWORDS * WORD_BITS;
+        }
+        enum EFirst{ FIRST = first_offset()};  //第一个格子在slab中的偏移
+        enum ENSlots{ NSLOTS = slot_count()};  //每个slab的格子数
+        static_assert(alignof(T) <= SLAB_BYTES, "T is over-aligned for a slab");
+
+        //每个线程当前用来分配的slab，以及曾经是当前slab、可能又有了空格子的slab
+        struct slab_pool{
+            slab *current;
+            size_t last;  //上一次分配的格子，下一次从它后面找
+            slab *partial_head;
+            slab *partial_tail;
+            slab_pool() : current(0), last(0), partial_head(0), partial_tail(0) {}
+            ~slab_pool();
+        };
+
+    public:
+        typedef T			value_type;
+        typedef T*			pointer;
+        typedef const T*	const_pointer;
+        typedef T&			reference;
+        typedef const T&	const_reference;
+        typedef size_t		size_type;
+        typedef ptrdiff_t	difference_type;
+    public:
+        slab_allocator() noexcept {}
+        template<class U>
+        slab_allocator(const slab_allocator<U> &) noexcept {}
+
+        //hint必须是由slab_allocator<T>分配、仍然存活的对象
+        static T *allocate(size_t n, const void *hint = 0);
+        static void deallocate(T *ptr, size_t n);
+        //依次分配，每一块以前一块为hint，第一块以hint为hint
+        static void allocate_batch(size_t n, size_t count, T **out, const void *hint = 0);
+        static void deallocate_batch(T **ptrs, size_t count, size_t n);
+
+        template<class U>
+        struct rebind{
+            using other = slab_allocator<U>;
+        };
+
+    private:
+        static slab_pool& pool(){
+            thread_local slab_pool p;
+            return p;
+        }
+        //本线程的slab_pool已经析构；放在slab_pool外面，析构函数里对它的写入才不会被编译器删掉
+        static bool& pool_dead(){
+            thread_local bool dead = false;
+            return dead;
+        }
+        static slab *slab_of(const void *ptr){
+            return (slab *)((uintptr_t)ptr & ~(uintptr_t)(SLAB_BYTES - 1));
+        }
+        static size_t slot_of(slab *s, const void *ptr){
+            return ((const char *)ptr - (const char *)s - EFirst::FIRST) / sizeof(T);
+        }
+        static T *slot_ptr(slab *s, size_t slot){
+            return (T *)((char *)s + EFirst::FIRST + slot * sizeof(T));
+        }
+        static slab *new_slab();
+        static void release(slab *s);
+        //在word中mask选中的空闲位里取一个，high为true时取最高的，否则取最低的；没有返回-1
+        static int claim_bit(std::atomic<uint64_t> &word, uint64_t mask, bool high);
+        //在s中取一个尽量靠近slot的空闲格子：先找slot之后的，再找之前的；s已满时返回-1
+        static ptrdiff_t claim_near(slab *s, size_t slot);
+        //从当前线程的slab里分配
+        static T *pool_allocate();
+        //slab_pool已经析构时的分配：新建一块slab分出一个格子
+        static T *orphan_allocate();
+        //把s挂到partial链表末尾，本线程对它的引用随之转给链表
+        static void push_partial(slab_pool &p, slab *s);
+        //在partial链表前面找一块有空格子的摘下来，连同本线程的引用一起交给调用者；
+        //看过的已满的slab移到末尾，多出来的整块空闲的slab还给tt::alloc
+        static slab *take_partial(slab_pool &p);
+    };
+
+    //无状态，所有实例总是相等
+    template<class T, class U>
+    bool operator==(const slab_allocator<T> &, const slab_allocator<U> &) { return true; }
+    template<class T, class U>
+    bool operator!=(const slab_allocator<T> &, const slab_allocator<U> &) { return false; }
+
+    template<class T>
+    slab_allocator<T>::slab_pool::~slab_pool(){
+        if (current){
+            release(current);
+        }
+        while (partial_head){
+            slab *s = partial_head;
+            partial_head = s->next_partial;
+            release(s);
+        }
+        pool_dead() = true;
+    }
+
+    template<class T>
+    T *slab_allocator<T>::allocate(size_t n, const void *hint){
+        if (n == 0) return 0;
+        if (n != 1){
+            return static_cast<T *>(alloc::allocate(sizeof(T) * n, alignof(T)));
+        }
+        if (hint){
+            //hint存活，它所在的slab不会在这期间被释放
+            slab *s = slab_of(hint);
+            s->refs.fetch_add(1, std::memory_order_relaxed);
+            ptrdiff_t slot = claim_near(s, slot_of(s, hint));
+            if (slot >= 0){
+                return slot_ptr(s, slot);
+            }
+            s->refs.fetch_sub(1, std::memory_order_relaxed);
+        }
+        return pool_allocate();
+    }
+    template<class T>
+    void slab_allocator<T>::deallocate(T *ptr, size_t n){
+        if (n == 0) return;
+        if (n != 1){
+            alloc::deallocate(static_cast<void *>(ptr), sizeof(T) * n, alignof(T));
+            return;
+        }
+        slab *s = slab_of(ptr);
+        size_t slot = slot_of(s, ptr);
+        s->free_bits[slot / EWordBits::WORD_BITS].fetch_or((uint64_t)1 << (slot % EWordBits::WORD_BITS), std::memory_order_release);
+        release(s);
+    }
+    template<class T>
+    void slab_allocator<T>::allocate_batch(size_t n, size_t count, T **out, const void *hint){
+        for (size_t i = 0; i < count; ++i){
+            out[i] = allocate(n, i ? out[i - 1] : hint);
+        }
+    }
+    template<class T>
+    void slab_allocator<T>::deallocate_batch(T **ptrs, size_t count, size_t n){
+        for (size_t i = 0; i < count; ++i){
+            deallocate(ptrs[i], n);
+        }
+    }
+
+    template<class T>
+    typename slab_allocator<T>::slab *slab_allocator<T>::new_slab(){
+        slab *s = static_cast<slab *>(alloc::allocate(ESlabBytes::SLAB_BYTES, ESlabBytes::SLAB_BYTES));
+        if (!s){
+            throw std::bad_alloc();
+        }
+        new(s) slab();
+        s->refs.store(1, std::memory_order_relaxed);  //当前线程持有的一份
+        s->next_partial = 0;
+        for (size_t i = 0; i < ENWords::NWORDS; ++i){
+            size_t first = i * EWordBits::WORD_BITS;
+            uint64_t bits = 0;
+            if (first + EWordBits::WORD_BITS <= ENSlots::NSLOTS){
+                bits = ~(uint64_t)0;
+            }
+            else if (first < ENSlots::NSLOTS){
+                bits = ((uint64_t)1 << (ENSlots::NSLOTS - first)) - 1;
+            }
+            s->free_bits[i].store(bits, std::memory_order_relaxed);
+        }
+        return s;
+    }
+    template<class T>
+    void slab_allocator<T>::release(slab *s){
+        if (s->refs.fetch_sub(1, std::memory_order_acq_rel) == 1){
+            s->~slab();
+            alloc::deallocate(s, ESlabBytes::SLAB_BYTES, ESlabBytes::SLAB_BYTES);
+        }
+    }
+    template<class T>
+    int slab_allocator<T>::claim_bit(std::atomic<uint64_t> &word, uint64_t mask, bool high){
+        uint64_t bits = word.load(std::memory_order_relaxed) & mask;
+        while (bits){
+            int i = high ? 63 - __builtin_clzll(bits) : __builtin_ctzll(bits);
+            uint64_t bit = (uint64_t)1 << i;
+            if (word.fetch_and(~bit, std::memory_order_acquire) & bit){
+                return i;
+            }
+            bits = word.load(std::memory_order_relaxed) & mask;  //被别的线程抢先了
+        }
+        return -1;
+    }
+    template<class T>
+    ptrdiff_t slab_allocator<T>::claim_near(slab *s, size_t slot){
+        size_t w = slot / EWordBits::WORD_BITS;
+        size_t b = slot % EWordBits::WORD_BITS;
+        uint64_t above = b + 1 < EWordBits::WORD_BITS ? ~(uint64_t)0 << (b + 1) : 0;
+        int i = claim_bit(s->free_bits[w], above, false);
+        if (i >= 0){
+            return w * EWordBits::WORD_BITS + i;
+        }
+        for (size_t k = w + 1; k < ENWords::NWORDS; ++k){
+            if ((i = claim_bit(s->free_bits[k], ~(uint64_t)0, false)) >= 0){
+                return k * EWordBits::WORD_BITS + i;
+            }
+        }
+        if ((i = claim_bit(s->free_bits[w], ~above, true)) >= 0){
+            return w * EWordBits::WORD_BITS + i;
+        }
+        for (size_t k = w; k-- > 0; ){
+            if ((i = claim_bit(s->free_bits[k], ~(uint64_t)0, true)) >= 0){
+                return k * EWordBits::WORD_BITS + i;
+            }
+        }
+        return -1;
+    }
+    template<class T>
+    T *slab_allocator<T>::pool_allocate(){
+        if (pool_dead()){
+            return orphan_allocate();
+        }
+        slab_pool &p = pool();
+        if (p.current){
+            p.current->refs.fetch_add(1, std::memory_order_relaxed);
+            ptrdiff_t slot = claim_near(p.current, p.last);
+            if (slot >= 0){
+                p.last = slot;
+                return slot_ptr(p.current, slot);
+            }
+            //已满：不再作为当前slab，挂到partial链表上，等其中的节点回收之后再用
+            p.current->refs.fetch_sub(1, std::memory_order_relaxed);
+            push_partial(p, p.current);
+            p.current = 0;
+        }
+        if (slab *s = take_partial(p)){
+            s->refs.fetch_add(1, std::memory_order_relaxed);
+            ptrdiff_t slot = claim_near(s, 0);
+            if (slot >= 0){
+                p.current = s;
+                p.last = slot;
+                return slot_ptr(s, slot);
+            }
+            //空格子被别的线程按hint抢先用掉了
+            s->refs.fetch_sub(1, std::memory_order_relaxed);
+            push_partial(p, s);
+        }
+        slab *s = new_slab();
+        s->refs.fetch_add(1, std::memory_order_relaxed);
+        s->free_bits[0].fetch_and(~(uint64_t)1, std::memory_order_relaxed);
+        p.current = s;
+        p.last = 0;
+        return slot_ptr(s, 0);
+    }
+    template<class T>
+    T *slab_allocator<T>::orphan_allocate(){
+        slab *s = new_slab();
+        //新建时的那份引用直接算作这个节点的
+        s->free_bits[0].fetch_and(~(uint64_t)1, std::memory_order_relaxed);
+        return slot_ptr(s, 0);
+    }
+    template<class T>
+    void slab_allocator<T>::push_partial(slab_pool &p, slab *s){
+        s->next_partial = 0;
+        if (p.partial_tail){
+            p.partial_tail->next_partial = s;
+        }
+        else{
+            p.partial_head = s;
+        }
+        p.partial_tail = s;
+    }
+    template<class T>
+    typename slab_allocator<T>::slab *slab_allocator<T>::take_partial(slab_pool &p){
+        slab *found = 0;
+        for (size_t k = 0; k < EPartialProbes::PARTIAL_PROBES && p.partial_head; ++k){
+            slab *s = p.partial_head;
+            p.partial_head = s->next_partial;
+            if (!p.partial_head){
+                p.partial_tail = 0;
+            }
+            //引用计数减去链表的一份就是存活的节点数
+            size_t live = s->refs.load(std::memory_order_acquire) - 1;
+            if (live == ENSlots::NSLOTS){
+                push_partial(p, s);
+            }
+            else if (!found){
+                found = s;
+            }
+            else if (live == 0){//只剩链表的引用，其他线程也拿不到它(没有存活的节点可以做hint)
+                release(s);
+            }
+            else{
+                push_partial(p, s);
+            }
+        }
+        return found;
+    }
+
+
+}  // namespace tt
+
+
+
+#endif //TINYSTL_SLAB_H
@@ -5,6 +5,7 @@
 #ifndef TINYSTL_TYPE_TRAITS_H
 #define TINYSTL_TYPE_TRAITS_H
 
+#include <type_traits>
 
 namespace tt{
     // integral_constant 是包装特定类型的静态常量。它是 C++ 类型特性的基类。
@@ -348,8 +349,11 @@ namespace tt{
     // 则该 class 就需要实现自己的 non-trivial-xxx。所以以上成员为 false_type。
     /**
      * type traits
-     * SGI 使用了保守的策略：将所有成员定义为 __false_type。
-     *                     而针对 C++ 内置类型（如 int）设计了偏特化版本的 __type_traits。
+     * SGI 使用了保守的策略：将所有成员定义为 __false_type，只对 C++ 内置类型（如 int）设计了偏特化版本。
+     * 这里改由编译器提供的 std::is_trivially_xxx 推导，只含标量成员的 struct 等类型也能自动
+     * 走 memcpy / memmove / 不调用析构函数 的快速路径；内置类型的偏特化保留，结果相同。
+     * is_POD_type 要求默认构造、拷贝构造、拷贝赋值、析构都是平凡的，这时在未初始化的内存上
+     * 直接赋值或 memcpy 和逐个构造是一样的。
      * @tparam type 内嵌类型（类）
      */
     template <class type>
@@ -359,11 +363,14 @@ namespace tt{
         // 但它与此处定义并无关联时，type traits 仍能顺利运作。
         using this_dummy_member_must_be_first = true_type;
 
-        using has_trivial_default_constructor = false_type;
-        using has_trivial_copy_constructor    = false_type;
-        using has_trivial_assignment_operator = false_type;
-        using has_trivial_destructor          = false_type;
-        using is_POD_type                     = false_type;
+        using has_trivial_default_constructor = typename integral_constant<bool, std::is_trivially_default_constructible<type>::value>::type;
+        using has_trivial_copy_constructor    = typename integral_constant<bool, std::is_trivially_copy_constructible<type>::value>::type;
+        using has_trivial_assignment_operator = typename integral_constant<bool, std::is_trivially_copy_assignable<type>::value>::type;
+        using has_trivial_destructor          = typename integral_constant<bool, std::is_trivially_destructible<type>::value>::type;
+        using is_POD_type                     = typename integral_constant<bool, std::is_trivial<type>::value &&
+                                                                                 std::is_trivially_copy_constructible<type>::value &&
+                                                                                 std::is_trivially_copy_assignable<type>::value &&
+                                                                                 std::is_trivially_destructible<type>::value>::type;
     };
 
     template <>
@@ -0,0 +1,717 @@
+//
+// Created by boyuan on 2022/4/27.
+//
+
+#ifndef TINYSTL_VECTOR_H
+#define TINYSTL_VECTOR_H
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "allocator.h"
+#include "allocator_traits.h"
+#include "iterator.h"
+#include "memory_aux.h"
+#include "construct.h"
+#include "algorithm.h"
+
+
+namespace tt {
+
+    // vector 保存元素的 allocator，无状态时通过 EBO 不占空间
+    template<class T, class Alloc = allocator<T>>
+    class vector : private allocator_holder<Alloc> {
+    public:
+        // 定义内嵌式类型
+        typedef T             value_type;
+        typedef T*            pointer;
+        typedef const T*      const_pointer;
+        typedef T&            reference;
+        typedef const T&      const_reference;
+        typedef T*            iterator;
+        typedef const T*      const_iterator;
+        typedef size_t        size_type;
+        typedef ptrdiff_t     difference_type;
+        typedef Alloc         allocator_type;
+
+    private:
+        typedef allocator_traits<Alloc>     data_traits;
+        typedef allocator_holder<Alloc>     base;
+
+        // 定义vector主要表达方式（3个指针）
+        iterator start;
+        iterator finish;
+        iterator end_of_storage;
+
+    public:
+        // 定义成员方法
+
+        // 构造 复制 析构
+        vector() : base(), start(0), finish(0), end_of_storage(0) {}
+        explicit vector(const allocator_type &a) : base(a), start(0), finish(0), end_of_storage(0) {}
+        explicit vector(size_type n, const allocator_type &a = allocator_type());
+        vector(size_type n, const value_type &val, const allocator_type &a = allocator_type());
+        vector(std::initializer_list<T> lists, const allocator_type &a = allocator_type());
+        template<class InputIterator>
+        vector(InputIterator first, InputIterator last, const allocator_type &a = allocator_type());
+        vector(const vector &v);
+        vector(vector &&v) noexcept;
+
+        vector& operator= (const vector &v);
+        vector& operator= (vector &&v) noexcept(data_traits::propagate_on_container_move_assignment::value ||
+                                                data_traits::is_always_equal::value);
+
+        ~vector();
+
+        allocator_type get_allocator() const { return this->get_alloc(); }
+
+        // 比较操作相关
+        bool operator== (const vector &v) const;
+        bool operator!= (const vector &v) const;
+
+        // 迭代器相关
+        iterator begin() {return start;}
+        const_iterator begin() const {return start;}
+        const_iterator cbegin() const {return start;}
+        iterator end() {return finish;}
+        const_iterator end() const {return finish;}
+        const_iterator cend() const {return finish;}
+
+        // 容量相关
+        size_type size() const {return size_type(finish - start);}
+        size_type capacity() const {return size_type(end_of_storage - start);}
+        bool empty() const  {return start == finish;}
+        void resize(size_type n, const value_type &val = value_type());
+        void reserve(size_type n);
+        void shrink_to_fit();
+
+        // 访问元素相关
+        reference operator[] (const size_type i) {return *(start + i);}
+        const_reference operator[] (const size_type i) const {return *(start + i);}
+        reference at(const size_type i) {return *(start + i);}
+        const_reference at(const size_type i) const {return *(start + i);}
+        reference front() {return *start;}
+        const_reference front() const {return *start;}
+        reference back() {return *(finish - 1);}
+        const_reference back() const {return *(finish - 1);}
+        pointer data() {return start;}
+        const_pointer data() const {return start;}
+
+        // 修改容器相关的操作
+        void clear();
+        void swap(vector &v);
+        void push_back(const value_type &value) { emplace_back(value); }
+        void push_back(value_type &&value) { emplace_back(std::move(value)); }
+        void pop_back();
+        // 用args原地构造元素
+        template<class... Args>
+        reference emplace_back(Args&&... args);
+        template<class... Args>
+        iterator emplace(iterator position, Args&&... args);
+        iterator insert(iterator position, const value_type &value);
+        iterator insert(iterator position, value_type &&value) { return emplace(position, std::move(value)); }
+        iterator insert(iterator position, const size_type n, const value_type &val);
+        template<class InputIterator>
+        iterator insert(iterator position, InputIterator first, InputIterator last);
+
+        iterator erase(iterator pos);
+        iterator erase(iterator first, iterator last);
+
+    private:
+        // 操作工具类方法
+        pointer allocate_storage(size_type n) { return n ? data_traits::allocate(this->get_alloc(), n) : pointer(); }
+        void deallocate_storage(pointer p, size_type n) { if (p) data_traits::deallocate(this->get_alloc(), p, n); }
+        void destroy_range(pointer first, pointer last) {
+            for (; first != last; ++first) {
+                data_traits::destroy(this->get_alloc(), first);
+            }
+        }
+        // 通过allocator在未初始化的result处逐个构造，返回末尾；抛出异常时析构已经构造好的元素
+        template<class InputIterator>
+        pointer construct_copy(InputIterator first, InputIterator last, pointer result);
+        pointer construct_fill_n(pointer result, size_type n, const value_type &val);
+
+        void allocate_fill_initialize(size_type n, const value_type& val);
+
+        template<class InputIterator>
+        void allocate_copy_initialize(InputIterator first, InputIterator last);
+
+        template<class InputIterator>
+        void range_initialize(InputIterator first, InputIterator last, true_type);   // InputIterator是整数
+
+        template<class InputIterator>
+        void range_initialize(InputIterator first, InputIterator last, false_type);
+
+        void destroy_and_deallocate_all();
+
+        // 可平凡搬移的元素扩容、在中间插入删除时整段 memmove，不再逐个拷贝、赋值
+        typedef typename is_trivially_relocatable<T>::type relocatable;
+        // 把[first, last)转移到未初始化的result，返回result的末尾：
+        // 可平凡搬移的类型搬过去，原处不用再析构；
+        // 其他类型通过allocator构造，移动构造不抛出异常时移动过去，否则拷贝过去，原处由release_storage析构
+        pointer transfer(pointer first, pointer last, pointer result, true_type) {
+            return tt::uninitialized_relocate(first, last, result);
+        }
+        pointer transfer(pointer first, pointer last, pointer result, false_type) {
+            pointer cur = result;
+            try {
+                for (; first != last; ++first, ++cur) {
+                    data_traits::construct(this->get_alloc(), cur, std::move_if_noexcept(*first));
+                }
+            } catch (...) {
+                destroy_range(result, cur);
+                throw;
+            }
+            return cur;
+        }
+        // 元素全部transfer之后释放旧空间
+        void release_storage(true_type);
+        void release_storage(false_type) { destroy_and_deallocate_all(); }
+        // 换到容量为new_capacity的新空间：new_start + (pos - start)起的n个新元素已经构造好，
+        // 把pos前后的元素转移到它们两侧；转移抛出异常时析构新空间里的元素并释放新空间，旧空间不变
+        iterator adopt_storage(pointer new_start, size_type new_capacity, iterator pos, size_type n);
+
+        iterator insert_aux(iterator pos, const size_type n, const value_type &val);
+        // 剩余空间足够时在pos处插入n个val
+        void insert_in_place(iterator pos, const size_type n, const value_type &val, true_type);
+        void insert_in_place(iterator pos, const size_type n, const value_type &val, false_type);
+        // 重新分配空间，新元素直接构造在新空间里
+        template<class... Args>
+        iterator realloc_emplace(iterator pos, Args&&... args);
+        // 剩余空间足够时在pos处原地构造一个元素
+        template<class... Args>
+        void emplace_in_place(iterator pos, true_type, Args&&... args);
+        template<class... Args>
+        void emplace_in_place(iterator pos, false_type, Args&&... args);
+        iterator erase_aux(iterator first, iterator last, true_type);
+        iterator erase_aux(iterator first, iterator last, false_type);
+
+        template<class InputIterator>
+        iterator insert_range_aux(iterator pos, InputIterator first, InputIterator last, true_type);
+
+        template<class InputIterator>
+        iterator insert_range_aux(iterator pos, InputIterator first, InputIterator last, false_type);
+
+        // 扩容后的容量：至少翻倍，并且放得下新增的n个
+        size_type get_new_cap(size_type n) const;
+
+    };
+
+
+    //***********************操作工具类方法***********************
+
+    template<class T, class Alloc>
+    void vector<T, Alloc>::allocate_fill_initialize(size_type n, const value_type &val) {
+        start = allocate_storage(n);
+        try {
+            finish = construct_fill_n(start, n, val);
+        } catch (...) {
+            deallocate_storage(start, n);
+            start = finish = end_of_storage = 0;
+            throw;
+        }
+        end_of_storage = finish;
+    }
+
+    template<class T, class Alloc>
+    template<class InputIterator>
+    void vector<T, Alloc>::allocate_copy_initialize(InputIterator first, InputIterator last) {
+        size_type n = 0;   // std的迭代器标签和tt的不同，不能用tt::distance
+        for (InputIterator it = first; it != last; ++it) {
+            ++n;
+        }
+        start = allocate_storage(n);
+        try {
+            finish = construct_copy(first, last, start);
+        } catch (...) {
+            // 复制赋值时也走这里，要让vector回到空的状态
+            deallocate_storage(start, n);
+            start = finish = end_of_storage = 0;
+            throw;
+        }
+        end_of_storage = finish;
+    }
+
+    template<class T, class Alloc>
+    template<class InputIterator>
+    void vector<T, Alloc>::range_initialize(InputIterator first, InputIterator last, true_type) {
+        allocate_fill_initialize(size_type(first), value_type(last));
+    }
+
+    template<class T, class Alloc>
+    template<class InputIterator>
+    void vector<T, Alloc>::range_initialize(InputIterator first, InputIterator last, false_type) {
+        allocate_copy_initialize(first, last);
+    }
+
+    template<class T, class Alloc>
+    void vector<T, Alloc>::destroy_and_deallocate_all() {
+        destroy_range(start, finish);
+        deallocate_storage(start, capacity());
+        start = finish = end_of_storage = 0;
+    }
+
+    template<class T, class Alloc>
+    template<class InputIterator>
+    typename vector<T, Alloc>::pointer
+    vector<T, Alloc>::construct_copy(InputIterator first, InputIterator last, pointer result) {
+        pointer cur = result;
+        try {
+            for (; first != last; ++first, ++cur) {
+                data_traits::construct(this->get_alloc(), cur, *first);
+            }
+        } catch (...) {
+            destroy_range(result, cur);
+            throw;
+        }
+        return cur;
+    }
+
+    template<class T, class Alloc>
+    typename vector<T, Alloc>::pointer
+    vector<T, Alloc>::construct_fill_n(pointer result, size_type n, const value_type &val) {
+        pointer cur = result;
+        try {
+            for (; n > 0; --n, ++cur) {
+                data_traits::construct(this->get_alloc(), cur, val);
+            }
+        } catch (...) {
+            destroy_range(result, cur);
+            throw;
+        }
+        return cur;
+    }
+
+    template<class T, class Alloc>
+    void vector<T, Alloc>::release_storage(true_type) {
+        deallocate_storage(start, capacity());
+        start = finish = end_of_storage = 0;
+    }
+
+    template<class T, class Alloc>
+    typename vector<T, Alloc>::iterator
+    vector<T, Alloc>::adopt_storage(pointer new_start, size_type new_capacity, iterator pos, size_type n) {
+        size_type elems_before = pos - start;
+        pointer new_pos = new_start + elems_before;
+        pointer new_finish = new_start;
+        try {
+            new_finish = transfer(start, pos, new_start, relocatable());  // 插入点之前的元素
+            new_finish = transfer(pos, finish, new_pos + n, relocatable());  // 插入点之后的元素
+        } catch (...) {
+            // 可平凡搬移时transfer不会抛出异常，走到这里旧空间的元素都还在
+            destroy_range(new_start, new_finish);
+            destroy_range(new_pos, new_pos + n);
+            deallocate_storage(new_start, new_capacity);
+            throw;
+        }
+        // 清除旧内容
+        release_storage(relocatable());
+        start = new_start;
+        finish = new_finish;
+        end_of_storage = start + new_capacity;
+        return new_pos;
+    }
+
+    // insert_aux
+    template<class T, class Alloc>
+    typename vector<T, Alloc>::iterator
+    vector<T, Alloc>::insert_aux(iterator pos, const size_type n, const value_type &val) {
+        if (n == 0) {
+            return pos;
+        }
+        size_type left_space = end_of_storage - finish;
+        if (left_space >= n) {   // 剩余空间 大于等于 所需空间
+            value_type copy = val;   // val可能就是容器里的元素，后移时会被覆盖
+            insert_in_place(pos, n, copy, relocatable());
+            return pos;
+        } else {    //  剩余空间 小于  所需空间
+            // 重新分配，先填好新的内容，再把插入点前后的元素转移过去
+            size_type new_capacity = get_new_cap(n);
+            size_type elems_before = pos - start;
+            iterator new_start = allocate_storage(new_capacity);
+            try {
+                construct_fill_n(new_start + elems_before, n, val);   // val可能是容器里的元素，要在转移之前复制
+            } catch (...) {
+                deallocate_storage(new_start, new_capacity);
+                throw;
+            }
+            return adopt_storage(new_start, new_capacity, pos, n);
+        }
+    }
+
+    template<class T, class Alloc>
+    void vector<T, Alloc>::insert_in_place(iterator pos, const size_type n, const value_type &val, true_type) {
+        // [pos, finish)整段后移n个位置，空出来的位置是未初始化的
+        tt::uninitialized_relocate(pos, finish, pos + n);
+        size_type i = 0;
+        try {
+            for (; i < n; ++i) {
+                data_traits::construct(this->get_alloc(), pos + i, val);
+            }
+        } catch (...) {
+            destroy_range(pos, pos + i);
+            tt::uninitialized_relocate(pos + n, finish + n, pos);   // 移回原处
+            throw;
+        }
+        finish += n;
+    }
+
+    template<class T, class Alloc>
+    void vector<T, Alloc>::insert_in_place(iterator pos, const size_type n, const value_type &val, false_type) {
+        const size_type elems_after = finish - pos;
+        iterator old_finish = finish;
+        if (elems_after > n) {  // 后移元素个数 大于 新增元素个数
+            construct_copy(std::make_move_iterator(finish - n), std::make_move_iterator(finish), finish);   // 先在后面填充n个
+            finish += n;
+            // [pos, old_finish - n) ==> [pos + n, old_finish)
+            tt::move_backward(pos, old_finish - n, old_finish);
+            // 填充新元素
+            tt::fill(pos, pos + n, val);
+        }else {  // 后移元素个数 小于等于 新增元素个数
+            construct_fill_n(finish, n - elems_after, val);
+            finish += n - elems_after;
+            construct_copy(std::make_move_iterator(pos), std::make_move_iterator(old_finish), finish);
+            finish += elems_after;
+            tt::fill(pos, old_finish, val);
+        }
+    }
+
+    template<class T, class Alloc>
+    template<class... Args>
+    typename vector<T, Alloc>::iterator
+    vector<T, Alloc>::realloc_emplace(iterator pos, Args&&... args) {
+        size_type new_capacity = get_new_cap(1);
+        size_type elems_before = pos - start;
+        iterator new_start = allocate_storage(new_capacity);
+        try {
+            // args可能引用容器里的元素，旧空间此时还完好
+            data_traits::construct(this->get_alloc(), new_start + elems_before, std::forward<Args>(args)...);
+        } catch (...) {
+            deallocate_storage(new_start, new_capacity);
+            throw;
+        }
+        return adopt_storage(new_start, new_capacity, pos, 1);
+    }
+
+    template<class T, class Alloc>
+    template<class... Args>
+    void vector<T, Alloc>::emplace_in_place(iterator pos, true_type, Args&&... args) {
+        // args可能引用容器里的元素，先在一旁构造好，后面的元素后移之后再把它的字节搬进空位
+        alignas(T) unsigned char buf[sizeof(T)];
+        pointer tmp = reinterpret_cast<pointer>(buf);
+        data_traits::construct(this->get_alloc(), tmp, std::forward<Args>(args)...);
+        tt::uninitialized_relocate(pos, finish, pos + 1);
+        tt::relocate_n(tmp, 1, pos);
+        ++finish;
+    }
+
+    template<class T, class Alloc>
+    template<class... Args>
+    void vector<T, Alloc>::emplace_in_place(iterator pos, false_type, Args&&... args) {
+        // 后面的元素要逐个移动后移，新元素先构造成临时对象(args可能引用容器里的元素)
+        value_type tmp(std::forward<Args>(args)...);
+        data_traits::construct(this->get_alloc(), finish, std::move(*(finish - 1)));
+        ++finish;
+        tt::move_backward(pos, finish - 2, finish - 1);
+        *pos = std::move(tmp);
+    }
+
+    template<class T, class Alloc>
+    typename vector<T, Alloc>::iterator
+    vector<T, Alloc>::erase_aux(iterator first, iterator last, true_type) {
+        destroy_range(first, last);
+        finish = tt::uninitialized_relocate(last, finish, first);   // 后面的元素整段前移
+        return first;
+    }
+
+    template<class T, class Alloc>
+    typename vector<T, Alloc>::iterator
+    vector<T, Alloc>::erase_aux(iterator first, iterator last, false_type) {
+        iterator i = tt::move(last, finish, first);
+        destroy_range(i, finish);
+        finish = i;
+        return first;
+    }
+
+    template<class T, class Alloc>
+    template<class InputIterator>
+    typename vector<T, Alloc>::iterator
+    vector<T, Alloc>::insert_range_aux(iterator pos, InputIterator first, InputIterator last, true_type) {
+        return insert_aux(pos, size_type(first), value_type(last));
+    }
+
+    template<class T, class Alloc>
+    template<class InputIterator>
+    typename vector<T, Alloc>::iterator
+    vector<T, Alloc>::insert_range_aux(iterator pos, InputIterator first, InputIterator last, false_type) {
+        // 逐个插入，插入可能重新分配，用下标重新定位
+        size_type index = pos - start;
+        size_type i = index;
+        for (; first != last; ++first, ++i) {
+            insert_aux(start + i, 1, *first);
+        }
+        return start + index;
+    }
+
+    // get_new_cap
+    template<class T, class Alloc>
+    typename vector<T, Alloc>::size_type
+    vector<T, Alloc>::get_new_cap(size_type n) const {
+        return size() + tt::max(size(), n);
+    }
+
+
+
+    //***********************构造，复制，析构相关***********************
+
+    // 构造
+
+    template<class T, class Alloc>
+    vector<T, Alloc>::vector(size_type n, const allocator_type &a) : base(a) {
+        allocate_fill_initialize(n, value_type());
+    }
+
+    template<class T, class Alloc>
+    vector<T, Alloc>::vector(size_type n, const value_type &val, const allocator_type &a) : base(a) {
+        allocate_fill_initialize(n, val);
+    }
+
+    template<class T, class Alloc>
+    vector<T, Alloc>::vector(std::initializer_list<T> lists, const allocator_type &a) : base(a) {
+        allocate_copy_initialize(lists.begin(), lists.end());
+    }
+
+    template<class T, class Alloc>
+    template<class InputIterator>
+    vector<T, Alloc>::vector(InputIterator first, InputIterator last, const allocator_type &a) : base(a) {
+        range_initialize(first, last, typename tt::is_integral<InputIterator>::type());
+    }
+
+    // 拷贝构造
+    template<class T, class Alloc>
+    vector<T, Alloc>::vector(const vector &v)
+        : base(data_traits::select_on_container_copy_construction(v.get_alloc())) {
+        allocate_copy_initialize(v.cbegin(), v.cend());
+    }
+
+    // 移动构造：直接接管v的空间
+    template<class T, class Alloc>
+    vector<T, Alloc>::vector(vector &&v) noexcept
+        : base(std::move(v.get_alloc())), start(v.start), finish(v.finish), end_of_storage(v.end_of_storage) {
+        v.start = v.finish = v.end_of_storage = 0;
+    }
+
+    // 析构
+    template<class T, class Alloc>
+    vector<T, Alloc>::~vector() {
+        destroy_and_deallocate_all();
+    }
+
+    //  复制赋值运算符  =
+    template<class T, class Alloc>
+    vector<T, Alloc> &vector<T, Alloc>::operator=(const vector &v) {
+        if (this != &v) {
+            if (data_traits::propagate_on_container_copy_assignment::value &&
+                !(this->get_alloc() == v.get_alloc())) {
+                // 换用v的allocator之前，旧空间必须还给原来的allocator
+                destroy_and_deallocate_all();
+            }
+            if (data_traits::propagate_on_container_copy_assignment::value) {
+                this->get_alloc() = v.get_alloc();
+            }
+            const size_type len = v.size();
+            if (len > capacity()) {   // v中变量的长度大于自己的容量：重新分配
+                destroy_and_deallocate_all();
+                allocate_copy_initialize(v.cbegin(), v.cend());
+            }else if (size() >= len){   // v的变量个数小于等于自己的size
+                iterator i = tt::copy(v.start, v.finish, start);
+                destroy_range(i, finish);
+                finish = start + len;
+            }else {   // v的变量个数大于自己的size，但小于capacity
+                tt::copy(v.start, v.start + size(), start);
+                construct_copy(v.start + size(), v.finish, finish);
+                finish = start + len;
+            }
+        }
+        return *this;
+    }
+
+    //  移动赋值运算符  =
+    template<class T, class Alloc>
+    vector<T, Alloc> &vector<T, Alloc>::operator=(vector &&v)
+            noexcept(data_traits::propagate_on_container_move_assignment::value || data_traits::is_always_equal::value) {
+        if (this != &v) {
+            if (data_traits::propagate_on_container_move_assignment::value || this->get_alloc() == v.get_alloc()) {
+                // 旧空间先还给原来的allocator，再接管v的空间
+                destroy_and_deallocate_all();
+                if (data_traits::propagate_on_container_move_assignment::value) {
+                    this->get_alloc() = std::move(v.get_alloc());
+                }
+                start = v.start;
+                finish = v.finish;
+                end_of_storage = v.end_of_storage;
+                v.start = v.finish = v.end_of_storage = 0;
+            }else {
+                // v的空间不能由自己的allocator释放，只能逐个移动元素
+                destroy_range(start, finish);
+                finish = start;
+                reserve(v.size());
+                finish = construct_copy(std::make_move_iterator(v.start), std::make_move_iterator(v.finish), start);
+                v.clear();
+            }
+        }
+        return *this;
+    }
+
+    // swap
+    template<class T, class Alloc>
+    void vector<T, Alloc>::swap(vector &v) {
+        // 两个allocator不相等且不随交换转移时，交换的结果是未定义的(同标准库)
+        if (data_traits::propagate_on_container_swap::value) {
+            tt::swap(this->get_alloc(), v.get_alloc());
+        }
+        tt::swap(start, v.start);
+        tt::swap(finish, v.finish);
+        tt::swap(end_of_storage, v.end_of_storage);
+    }
+
+    // ==
+    template<class T, class Alloc>
+    bool vector<T, Alloc>::operator==(const vector &v) const {
+        if (size() != v.size()) {
+            return false;
+        }
+        for (const_iterator ptr1 = start, ptr2 = v.start; ptr1 != finish; ++ptr1, ++ptr2) {
+            if (!(*ptr1 == *ptr2)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // !=
+    template<class T, class Alloc>
+    bool vector<T, Alloc>::operator!=(const vector &v) const {
+        return !(*this == v);
+    }
+
+    // resize
+    template<class T, class Alloc>
+    void vector<T, Alloc>::resize(size_type n, const value_type &val) {
+        if (n < size()) {  // 新空间比当前空间小: 删除(调用析构函数 + 更新迭代器位置)后面的
+            erase(begin() + n, end());
+        }else {     // 新空间比当前空间大: 在后面的插入
+            insert(end(), n - size(), val);
+        }
+    }
+
+    // reserve
+    template<class T, class Alloc>
+    void vector<T, Alloc>::reserve(size_type n) {
+        if (n <= capacity()) {  // 新的capacity小于等于旧的：啥也不做
+            return;
+        }
+        adopt_storage(allocate_storage(n), n, finish, 0);
+    }
+
+    // shrink_to_fit
+    template<class T, class Alloc>
+    void vector<T, Alloc>::shrink_to_fit() {
+        if (finish == end_of_storage) {
+            return;
+        }
+        size_type n = size();
+        adopt_storage(allocate_storage(n), n, finish, 0);
+    }
+
+    // clear
+    template<class T, class Alloc>
+    void vector<T, Alloc>::clear() {
+        erase(begin(), end());
+    }
+
+    // emplace_back
+    template<class T, class Alloc>
+    template<class... Args>
+    typename vector<T, Alloc>::reference
+    vector<T, Alloc>::emplace_back(Args&&... args) {
+        if (finish != end_of_storage) {  // 还有备用空间
+            data_traits::construct(this->get_alloc(), finish, std::forward<Args>(args)...);
+            ++finish;
+        }else {
+            realloc_emplace(end(), std::forward<Args>(args)...);
+        }
+        return back();
+    }
+
+    template<class T, class Alloc>
+    template<class... Args>
+    typename vector<T, Alloc>::iterator
+    vector<T, Alloc>::emplace(iterator position, Args&&... args) {
+        if (finish == end_of_storage) {
+            return realloc_emplace(position, std::forward<Args>(args)...);
+        }
+        if (position == finish) {
+            data_traits::construct(this->get_alloc(), finish, std::forward<Args>(args)...);
+            ++finish;
+        }else {
+            emplace_in_place(position, relocatable(), std::forward<Args>(args)...);
+        }
+        return position;
+    }
+
+    template<class T, class Alloc>
+    void vector<T, Alloc>::pop_back() {
+        --finish;
+        data_traits::destroy(this->get_alloc(), finish);
+    }
+
+    template<class T, class Alloc>
+    typename vector<T, Alloc>::iterator
+    vector<T, Alloc>::insert(iterator position, const value_type &value) {
+        return insert_aux(position, 1, value);
+    }
+
+    template<class T, class Alloc>
+    typename vector<T, Alloc>::iterator
+    vector<T, Alloc>::insert(iterator position, const size_type n, const value_type &val) {
+        return insert_aux(position, n, val);
+    }
+
+    template<class T, class Alloc>
+    template<class InputIterator>
+    typename vector<T, Alloc>::iterator
+    vector<T, Alloc>::insert(iterator position, InputIterator first, InputIterator last) {
+        return insert_range_aux(position, first, last, typename tt::is_integral<InputIterator>::type());
+    }
+
+    template<class T, class Alloc>
+    typename vector<T, Alloc>::iterator
+    vector<T, Alloc>::erase(iterator pos) {
+        return erase(pos, pos + 1);
+    }
+
+    template<class T, class Alloc>
+    typename vector<T, Alloc>::iterator
+    vector<T, Alloc>::erase(iterator first, iterator last) {
+        if (first != last) {
+            erase_aux(first, last, relocatable());
+        }
+        return first;
+    }
+
+
+
+
+} // namespace tt
+
+
+
+
+
+
+
+#endif //TINYSTL_VECTOR_H
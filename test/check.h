@@ -0,0 +1,20 @@
+//
+// Created on 2026/10/18.
+//
+
+#ifndef TINYSTL_TEST_CHECK_H
+#define TINYSTL_TEST_CHECK_H
+
+#include <cstdio>
+#include <cstdlib>
+
+//测试用的断言，不受NDEBUG影响，失败时打印位置并以非0退出
+#define CHECK(cond) \
+    do { \
+        if (!(cond)) { \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            std::exit(1); \
+        } \
+    } while (0)
+
+#endif //TINYSTL_TEST_CHECK_H
@@ -0,0 +1,127 @@
+//
+// Created on 2026/10/18.
+//
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "rcu.h"
+#include "check.h"
+
+enum EConfig{ FIELDS = 16};
+
+static std::atomic<int> live(0);
+
+//每个版本的所有字段都等于version，读者据此判断读到的是不是完整的一版
+struct config{
+    long version;
+    long fields[EConfig::FIELDS];
+
+    config() : version(0) {
+        for (long &f : fields) f = 0;
+        live.fetch_add(1, std::memory_order_relaxed);
+    }
+    config(const config &c) : version(c.version) {
+        for (int i = 0; i < EConfig::FIELDS; ++i) fields[i] = c.fields[i];
+        live.fetch_add(1, std::memory_order_relaxed);
+    }
+    ~config() {
+        //被提前delete的话读者会读到-1
+        version = -1;
+        for (long &f : fields) f = -1;
+        live.fetch_sub(1, std::memory_order_relaxed);
+    }
+};
+
+static void check_consistent(const config &c) {
+    CHECK(c.version >= 0);
+    for (long f : c.fields) {
+        CHECK(f == c.version);
+    }
+}
+
+static void test_readers_and_writers() {
+    enum{ READERS = 4, WRITERS = 2, UPDATES = 2000};
+    tt::rcu_ptr<config> cfg(new config());
+    std::atomic<bool> done(false);
+
+    std::vector<std::thread> threads;
+    for (int r = 0; r < READERS; ++r) {
+        threads.emplace_back([&] {
+            long last = 0;
+            while (!done.load(std::memory_order_acquire)) {
+                tt::rcu_ptr<config>::snapshot s = cfg.read();
+                CHECK(s);
+                //同一个读者看到的版本不会倒退
+                CHECK(s->version >= last);
+                last = s->version;
+                //持有快照期间写者换了版本，这一版也不能被回收
+                for (int k = 0; k < 4; ++k) {
+                    check_consistent(*s);
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for (int w = 0; w < WRITERS; ++w) {
+        writers.emplace_back([&] {
+            for (int i = 0; i < UPDATES; ++i) {
+                cfg.update([](config &c) {
+                    ++c.version;
+                    for (long &f : c.fields) f = c.version;
+                });
+                if (i % 256 == 0) {
+                    tt::rcu::synchronize();
+                }
+            }
+        });
+    }
+    for (std::thread &t : writers) {
+        t.join();
+    }
+    done.store(true, std::memory_order_release);
+    for (std::thread &t : threads) {
+        t.join();
+    }
+
+    {
+        tt::rcu_ptr<config>::snapshot s = cfg.read();
+        CHECK(s->version == long(WRITERS) * UPDATES);
+        check_consistent(*s);
+    }
+    //所有读者都已退出，宽限期过后旧版本全部delete，只剩当前版本
+    tt::rcu::synchronize();
+    CHECK(live.load() == 1);
+}
+
+static void test_store_and_synchronize() {
+    tt::rcu_ptr<config> cfg;
+    {
+        tt::rcu_ptr<config>::snapshot s = cfg.read();
+        CHECK(!s);
+    }
+    cfg.emplace();
+    config *next = new config();
+    next->version = 7;
+    for (long &f : next->fields) f = 7;
+    {
+        tt::rcu_ptr<config>::snapshot old = cfg.read();
+        cfg.store(next);
+        //旧快照仍然指向换下来的版本
+        CHECK(old->version == 0);
+        check_consistent(*old);
+        CHECK(cfg.read()->version == 7);
+    }
+    tt::rcu::synchronize();
+    CHECK(live.load() == 1);
+}
+
+int main() {
+    test_readers_and_writers();
+    CHECK(live.load() == 0);
+    test_store_and_synchronize();
+    CHECK(live.load() == 0);
+    return 0;
+}
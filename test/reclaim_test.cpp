@@ -0,0 +1,151 @@
+//
+// Created on 2026/10/18.
+//
+
+#include <atomic>
+#include <new>
+#include <thread>
+#include <vector>
+
+#include "reclaim.h"
+#include "check.h"
+
+enum EStress{ THREADS = 8, ITERATIONS = 20000, SLOTS = 4};
+
+static std::atomic<long> constructed(0);
+static std::atomic<long> destroyed(0);
+
+//析构时把值改成-1，回收过早的话读者会读到
+struct node{
+    long value;
+    long check;
+
+    explicit node(long v) : value(v), check(~v) { constructed.fetch_add(1, std::memory_order_relaxed); }
+    ~node() {
+        value = -1;
+        check = -1;
+        destroyed.fetch_add(1, std::memory_order_relaxed);
+    }
+    bool intact() const { return value >= 0 && check == ~value; }
+};
+
+static void reset_counters() {
+    constructed.store(0);
+    destroyed.store(0);
+}
+
+//每个线程反复读几个共享指针，其中一部分操作把读到的节点换掉并retire
+static void test_ebr() {
+    reset_counters();
+    std::atomic<node *> slots[EStress::SLOTS];
+    for (int i = 0; i < EStress::SLOTS; ++i) {
+        slots[i].store(new node(0));
+    }
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < EStress::THREADS; ++t) {
+        threads.emplace_back([&slots, t] {
+            for (long i = 0; i < EStress::ITERATIONS; ++i) {
+                std::atomic<node *> &slot = slots[(t + i) % EStress::SLOTS];
+                tt::ebr::guard g;
+                node *n = slot.load(std::memory_order_acquire);
+                CHECK(n->intact());
+                if (i % 4 == 0) {
+                    node *old = slot.exchange(new node(i), std::memory_order_acq_rel);
+                    //old被摘下之后本线程仍在临界区里读它
+                    CHECK(old->intact());
+                    tt::ebr::retire(old);
+                }
+                CHECK(n->intact());
+            }
+            //与其余线程的retire并发地等一次宽限期
+            if (t == 0) {
+                tt::ebr::synchronize();
+            }
+        });
+    }
+    for (std::thread &t : threads) {
+        t.join();
+    }
+
+    //退出的线程留下的对象也要在宽限期过后回收
+    tt::ebr::synchronize();
+    CHECK(destroyed.load() == constructed.load() - EStress::SLOTS);
+    for (int i = 0; i < EStress::SLOTS; ++i) {
+        delete slots[i].load();
+    }
+    CHECK(destroyed.load() == constructed.load());
+}
+
+//retire_node交出的tt::alloc内存成批还给内存池
+static void test_ebr_retire_node() {
+    reset_counters();
+    std::atomic<node *> head(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < EStress::THREADS; ++t) {
+        threads.emplace_back([&head] {
+            for (long i = 0; i < EStress::ITERATIONS / 4; ++i) {
+                tt::ebr::guard g;
+                node *n = ::new(tt::alloc::allocate(sizeof(node), alignof(node))) node(i);
+                node *old = head.exchange(n, std::memory_order_acq_rel);
+                if (old) {
+                    CHECK(old->intact());
+                    tt::ebr::retire_node(old);
+                }
+            }
+        });
+    }
+    for (std::thread &t : threads) {
+        t.join();
+    }
+    tt::ebr::synchronize();
+    CHECK(destroyed.load() == constructed.load() - 1);
+    node *last = head.load();
+    last->~node();
+    tt::alloc::deallocate(last, sizeof(node), alignof(node));
+}
+
+static void test_hazard_pointer() {
+    reset_counters();
+    std::atomic<node *> slots[EStress::SLOTS];
+    for (int i = 0; i < EStress::SLOTS; ++i) {
+        slots[i].store(new node(0));
+    }
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < EStress::THREADS; ++t) {
+        threads.emplace_back([&slots, t] {
+            tt::hazard_pointer::holder h, h2;
+            for (long i = 0; i < EStress::ITERATIONS; ++i) {
+                node *n = h.protect(slots[(t + i) % EStress::SLOTS]);
+                node *m = h2.protect(slots[(t + i + 1) % EStress::SLOTS]);
+                CHECK(n->intact() && m->intact());
+                if (i % 4 == 0) {
+                    node *old = slots[(t + i) % EStress::SLOTS].exchange(new node(i), std::memory_order_acq_rel);
+                    tt::hazard_pointer::retire(old);
+                }
+                //被登记的n即使已被别的线程换下并retire也仍然有效
+                CHECK(n->intact() && m->intact());
+                h.clear();
+            }
+        });
+    }
+    for (std::thread &t : threads) {
+        t.join();
+    }
+
+    //线程退出时回收不了的对象交给了orphans，这时已经没有登记的指针
+    tt::hazard_pointer::reclaim();
+    CHECK(destroyed.load() == constructed.load() - EStress::SLOTS);
+    for (int i = 0; i < EStress::SLOTS; ++i) {
+        delete slots[i].load();
+    }
+    CHECK(destroyed.load() == constructed.load());
+}
+
+int main() {
+    test_ebr();
+    test_ebr_retire_node();
+    test_hazard_pointer();
+    return 0;
+}
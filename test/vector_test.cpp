@@ -0,0 +1,142 @@
+//
+// Created on 2026/10/18.
+//
+
+#include <new>
+#include <string>
+
+#include "vector.h"
+#include "memory_resource.h"
+#include "check.h"
+
+template<class T>
+using pmr_vector = tt::vector<T, tt::polymorphic_allocator<T>>;
+
+//按值填入0..n-1，途中会多次扩容
+template<class Vec>
+static void fill(Vec &v, int n) {
+    for (int i = 0; i < n; ++i) {
+        v.push_back(typename Vec::value_type(std::to_string(i)));
+    }
+}
+
+template<class Vec>
+static void check_sequence(const Vec &v, int n) {
+    CHECK(v.size() == size_t(n));
+    for (int i = 0; i < n; ++i) {
+        CHECK(v[i] == std::to_string(i));
+    }
+}
+
+static void test_default_allocator() {
+    tt::vector<std::string> v;
+    fill(v, 100);
+    check_sequence(v, 100);
+    v.insert(v.begin(), "x");
+    v.erase(v.begin());
+    check_sequence(v, 100);
+    tt::vector<std::string> w(v);
+    CHECK(w == v);
+}
+
+static void test_monotonic_resource() {
+    tt::monotonic_resource mr(256);
+    {
+        pmr_vector<std::string> v(&mr);
+        fill(v, 1000);
+        check_sequence(v, 1000);
+        CHECK(v.get_allocator().resource() == &mr);
+
+        //同一resource之间移动赋值直接接管存储
+        pmr_vector<std::string> w(&mr);
+        w = std::move(v);
+        check_sequence(w, 1000);
+        CHECK(v.empty());
+
+        //拷贝构造时新容器使用默认resource
+        pmr_vector<std::string> c(w);
+        CHECK(c.get_allocator().resource() == tt::get_default_resource());
+        CHECK(c == w);
+
+        w.shrink_to_fit();
+        w.resize(10);
+        check_sequence(w, 10);
+    }
+    mr.release();
+
+    //不同resource之间移动赋值要逐个搬过去
+    pmr_vector<int> a(&mr), b(tt::get_pool_resource());
+    for (int i = 0; i < 64; ++i) {
+        a.push_back(i);
+    }
+    b = std::move(a);
+    CHECK(b.size() == 64 && b.get_allocator().resource() == tt::get_pool_resource());
+    for (int i = 0; i < 64; ++i) {
+        CHECK(b[i] == i);
+    }
+}
+
+static void test_null_resource() {
+    pmr_vector<int> v(tt::get_null_resource());
+    //不分配的操作都可以做
+    CHECK(v.empty() && v.capacity() == 0);
+    v.clear();
+    v.reserve(0);
+
+    bool thrown = false;
+    try {
+        v.push_back(1);
+    }
+    catch (const std::bad_alloc &) {
+        thrown = true;
+    }
+    CHECK(thrown);
+    CHECK(v.empty() && v.capacity() == 0);
+
+    //分配失败时已有元素保持不变
+    pmr_vector<int> w(3, 7, tt::get_pool_resource());
+    w.shrink_to_fit();
+    tt::memory_resource *old = tt::set_default_resource(tt::get_null_resource());
+    thrown = false;
+    try {
+        pmr_vector<int> c(w);
+    }
+    catch (const std::bad_alloc &) {
+        thrown = true;
+    }
+    tt::set_default_resource(old);
+    CHECK(thrown);
+    CHECK(w.size() == 3 && w[0] == 7 && w[2] == 7);
+}
+
+static void test_pool_resource() {
+    pmr_vector<std::string> v(tt::get_pool_resource());
+    fill(v, 500);
+    check_sequence(v, 500);
+    v.erase(v.begin() + 100, v.end());
+    check_sequence(v, 100);
+
+    pmr_vector<std::string> w(tt::get_pool_resource());
+    w.swap(v);
+    check_sequence(w, 100);
+    CHECK(v.empty());
+
+    //polymorphic_allocator本身也可以单独用
+    tt::polymorphic_allocator<double> a(tt::get_pool_resource());
+    double *p = a.allocate(16);
+    for (int i = 0; i < 16; ++i) {
+        p[i] = i;
+    }
+    CHECK(p[15] == 15);
+    a.deallocate(p, 16);
+    CHECK(a == tt::polymorphic_allocator<int>(tt::get_pool_resource()));
+    CHECK(a != tt::polymorphic_allocator<int>(tt::get_null_resource()));
+}
+
+int main() {
+    test_default_allocator();
+    test_monotonic_resource();
+    test_null_resource();
+    test_pool_resource();
+    return 0;
+}